@@ -0,0 +1,237 @@
+# Validates the shaders and embeds their sources into a C++ file, run with cmake -P:
+#   SHADER_DIR  directory holding the shaders, includes in subdirectories
+#   OUTPUT      the generated .cpp, see src/embeddedShaders.h
+#   GLSLANG     glslangValidator, validation is skipped when empty
+#   WORK_DIR    where the expanded shaders are written for the validator
+#   SPIRV       ON to compile the Vulkan shaders with GLSLANG and embed the SPIR-V as well
+
+cmake_minimum_required(VERSION 3.20)
+
+# feature defines of shaderUtils::Feature, every combination is validated
+set(FEATURE_DEFINES REVERSE_MODE WAVE_ACTIVE ANALYTIC_AA)
+
+# shaders OpenGL ES 3.0 never runs, they need buffer textures or compute shaders.
+# The others are validated a second time as GLSL ES 3.00
+set(DESKTOP_ONLY_SHADERS edge_vertex.glsl edge_cull_compute.glsl)
+
+# shaders the Vulkan backend draws with, compiled to SPIR-V in every feature combination they read
+set(VULKAN_SHADERS fullscreen_vertex.glsl procedural_fragment.glsl)
+
+# what shaderUtils::compileShaders puts after the defines on OpenGL ES
+set(ES_PRECISIONS "precision highp float;\nprecision highp int;\nprecision mediump sampler2D;\n")
+
+# MSVC can't take longer string literals, adjacent ones are joined by the compiler
+set(CHUNK_SIZE 8000)
+
+# Expands #include "file" relative to the including file, every file once.
+# INCLUDED holds what was expanded so far, in the caller's scope
+function(expand_includes path out_var)
+    file(READ "${path}" source)
+    get_filename_component(directory "${path}" DIRECTORY)
+
+    string(REGEX MATCHALL "[ \t]*#include[ \t]*\"[^\"]+\"[^\n]*" directives "${source}")
+    foreach(directive IN LISTS directives)
+        string(REGEX REPLACE ".*\"([^\"]+)\".*" "\\1" name "${directive}")
+        get_filename_component(include_path "${directory}/${name}" ABSOLUTE)
+        set(expanded "")
+        if(NOT include_path IN_LIST INCLUDED)
+            list(APPEND INCLUDED "${include_path}")
+            expand_includes("${include_path}" expanded)
+        endif()
+        string(REPLACE "${directive}" "${expanded}" source "${source}")
+    endforeach()
+
+    set(INCLUDED "${INCLUDED}" PARENT_SCOPE)
+    set(${out_var} "${source}" PARENT_SCOPE)
+endfunction()
+
+# the glslangValidator stage of a shader, from the end of its name
+function(shader_stage name out_var)
+    if(name MATCHES "_vertex\\.glsl$")
+        set(${out_var} vert PARENT_SCOPE)
+    elseif(name MATCHES "_fragment\\.glsl$")
+        set(${out_var} frag PARENT_SCOPE)
+    elseif(name MATCHES "_compute\\.glsl$")
+        set(${out_var} comp PARENT_SCOPE)
+    else()
+        message(FATAL_ERROR "${name}: can't tell the stage, shader names end in _vertex, _fragment or _compute")
+    endif()
+endfunction()
+
+# the #define lines of the FEATURE_DEFINES bits set in combination
+function(feature_defines combination out_var)
+    set(defines "")
+    set(index 0)
+    foreach(define IN LISTS FEATURE_DEFINES)
+        math(EXPR bit "(${combination} >> ${index}) & 1")
+        if(bit)
+            string(APPEND defines "#define ${define}\n")
+        endif()
+        math(EXPR index "${index} + 1")
+    endforeach()
+    set(${out_var} "${defines}" PARENT_SCOPE)
+endfunction()
+
+list(LENGTH FEATURE_DEFINES feature_count)
+math(EXPR combination_count "(1 << ${feature_count}) - 1")
+
+file(GLOB_RECURSE shader_files RELATIVE "${SHADER_DIR}" "${SHADER_DIR}/*.glsl")
+list(SORT shader_files)
+
+# ---------- offline validation ----------
+if(GLSLANG)
+    foreach(name IN LISTS shader_files)
+        # includes are validated as part of the stages that use them
+        if(name MATCHES "/")
+            continue()
+        endif()
+        shader_stage("${name}" stage)
+
+        set(INCLUDED "")
+        expand_includes("${SHADER_DIR}/${name}" expanded)
+
+        foreach(combination RANGE ${combination_count})
+            feature_defines(${combination} defines)
+
+            # the defines go right after #version, like shaderUtils::compileShaders puts them
+            string(REGEX REPLACE "(#version[^\n]*\n)" "\\1${defines}" variant "${expanded}")
+            get_filename_component(base "${name}" NAME_WE)
+            set(variant_path "${WORK_DIR}/${base}_${combination}.${stage}")
+            file(WRITE "${variant_path}" "${variant}")
+
+            execute_process(
+                COMMAND "${GLSLANG}" "${variant_path}"
+                RESULT_VARIABLE result
+                OUTPUT_VARIABLE output
+                ERROR_VARIABLE output
+            )
+            if(NOT result EQUAL 0)
+                message(FATAL_ERROR "${name} fails to validate with features ${combination}:\n${output}")
+            endif()
+
+            if(name IN_LIST DESKTOP_ONLY_SHADERS)
+                continue()
+            endif()
+
+            # the same sources as GLSL ES, the validator takes the profile from #version
+            string(REGEX REPLACE "#version[^\n]*\n" "#version 300 es\n${defines}${ES_PRECISIONS}" es_variant "${expanded}")
+            set(es_variant_path "${WORK_DIR}/${base}_${combination}_es.${stage}")
+            file(WRITE "${es_variant_path}" "${es_variant}")
+
+            execute_process(
+                COMMAND "${GLSLANG}" "${es_variant_path}"
+                RESULT_VARIABLE result
+                OUTPUT_VARIABLE output
+                ERROR_VARIABLE output
+            )
+            if(NOT result EQUAL 0)
+                message(FATAL_ERROR "${name} fails to validate as GLSL ES with features ${combination}:\n${output}")
+            endif()
+        endforeach()
+    endforeach()
+endif()
+
+# ---------- SPIR-V for the Vulkan backend ----------
+# the same sources with VULKAN defined, which swaps the loose uniforms and the Frame block
+# for Vulkan's descriptor sets and push constants. Output locations are assigned by the
+# compiler, every shader has one output at most
+set(spirv_arrays "")
+string(REPEAT "0x........," 8 words_per_line)
+set(spirv_entries "")
+if(SPIRV)
+    if(NOT GLSLANG)
+        message(FATAL_ERROR "SPIR-V needs glslangValidator")
+    endif()
+
+    foreach(name IN LISTS VULKAN_SHADERS)
+        shader_stage("${name}" stage)
+        set(INCLUDED "")
+        expand_includes("${SHADER_DIR}/${name}" expanded)
+        get_filename_component(base "${name}" NAME_WE)
+
+        # a shader that reads no feature define is compiled once, as combination 0
+        set(last_combination 0)
+        foreach(define IN LISTS FEATURE_DEFINES)
+            string(FIND "${expanded}" "${define}" position)
+            if(position GREATER_EQUAL 0)
+                set(last_combination ${combination_count})
+            endif()
+        endforeach()
+
+        foreach(combination RANGE ${last_combination})
+            feature_defines(${combination} defines)
+            string(REGEX REPLACE "#version[^\n]*\n" "#version 450\n#define VULKAN\n${defines}" variant "${expanded}")
+            set(variant_path "${WORK_DIR}/${base}_${combination}_vulkan.${stage}")
+            file(WRITE "${variant_path}" "${variant}")
+
+            execute_process(
+                COMMAND "${GLSLANG}" -V --target-env vulkan1.0 --auto-map-locations -o "${variant_path}.spv" "${variant_path}"
+                RESULT_VARIABLE result
+                OUTPUT_VARIABLE output
+                ERROR_VARIABLE output
+            )
+            if(NOT result EQUAL 0)
+                message(FATAL_ERROR "${name} fails to compile to SPIR-V with features ${combination}:\n${output}")
+            endif()
+
+            # glslangValidator writes words in host order, little-endian everywhere this builds
+            file(READ "${variant_path}.spv" hex HEX)
+            string(REGEX REPLACE "(..)(..)(..)(..)" "0x\\4\\3\\2\\1," words "${hex}")
+            string(REGEX REPLACE "(${words_per_line})" "\\1\n" words "${words}")
+            set(array "spirv_${base}_${combination}")
+            string(APPEND spirv_arrays "static constexpr std::uint32_t ${array}[] = {\n${words}\n};\n")
+            string(APPEND spirv_entries "        { \"${name}\", ${combination}u, ${array} },\n")
+        endforeach()
+    endforeach()
+endif()
+
+# ---------- embedded sources ----------
+set(entries "")
+foreach(name IN LISTS shader_files)
+    file(READ "${SHADER_DIR}/${name}" source)
+    if(source MATCHES "\\)glsl\"")
+        message(FATAL_ERROR "${name} contains the raw string delimiter )glsl\"")
+    endif()
+
+    string(LENGTH "${source}" length)
+    set(literal "")
+    set(offset 0)
+    while(offset LESS length)
+        string(SUBSTRING "${source}" ${offset} ${CHUNK_SIZE} chunk)
+        string(APPEND literal "R\"glsl(${chunk})glsl\"\n")
+        math(EXPR offset "${offset} + ${CHUNK_SIZE}")
+    endwhile()
+    if(literal STREQUAL "")
+        set(literal "\"\"\n")
+    endif()
+
+    string(APPEND entries "    { \"${name}\",\n${literal}    },\n")
+endforeach()
+
+if(spirv_entries STREQUAL "")
+    set(spirv_table "    return {};\n")
+else()
+    set(spirv_table "    static constexpr EmbeddedSpirv spirv[] = {\n${spirv_entries}    };\n    return spirv;\n")
+endif()
+
+set(generated "// Generated by cmake/EmbedShaders.cmake from the shaders directory, do not edit
+#include \"embeddedShaders.h\"
+
+static constexpr EmbeddedShader shaders[] = {
+${entries}};
+
+std::span<const EmbeddedShader> embeddedShaders() {
+    return shaders;
+}
+${spirv_arrays}
+std::span<const EmbeddedSpirv> embeddedSpirv() {
+${spirv_table}}
+")
+
+# only touched when something changed, so the file isn't recompiled on every build
+if(EXISTS "${OUTPUT}")
+    file(READ "${OUTPUT}" previous)
+endif()
+if(NOT "${previous}" STREQUAL "${generated}")
+    file(WRITE "${OUTPUT}" "${generated}")
+endif()
@@ -0,0 +1,30 @@
+#version 330 core
+
+// Resolved coverage of the full edge layer
+uniform sampler2D coverageLayer;
+
+#include "include/hex_grid.glsl"
+#include "include/palette.glsl"
+#include "include/edge_shading.glsl"
+
+out mediump vec4 FragColor;
+
+void main() {
+    float coverage = texelFetch(coverageLayer, ivec2(gl_FragCoord.xy), 0).r;
+    if (coverage <= 0.0) {
+        discard;
+    }
+
+    // the covered segment is the nearest side of the triangle under this pixel
+    vec2 p = gl_FragCoord.xy;
+    ivec2 cell;
+    vec2 center = cellCenter(p, cell);
+    int triangle = sectorTriangle(p, center);
+    vec2 a = center + corners[triangleCorners[triangle * 2]];
+    vec2 b = center + corners[triangleCorners[triangle * 2 + 1]];
+
+    vec2 e1, e2;
+    nearestTriangleSide(p, center, a, b, e1, e2);
+    vec4 edge = edgeShade(e1, e2, paletteColor(3));
+    FragColor = vec4(edge.rgb, edge.a * coverage);
+}
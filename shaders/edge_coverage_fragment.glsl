@@ -0,0 +1,13 @@
+#version 330 core
+
+#include "include/edge_shading.glsl"
+
+in vec2 vEdgeP1;
+in vec2 vEdgeP2;
+
+// Pixel coverage of the edge, the same one edge_fragment.glsl multiplies its alpha with
+out mediump vec4 FragColor;
+
+void main() {
+    FragColor = vec4(edgeCoverage(pointToSegmentDistance(gl_FragCoord.xy, vEdgeP1, vEdgeP2), edgeWidth * 0.5));
+}
@@ -0,0 +1,64 @@
+#version 430 core
+
+// Outside reverse mode an edge is only visible near the cursor and under the wave.
+// Copies the records of those edges into a compacted list and counts their vertices
+// in the indirect draw command, so the edge pass only draws what can show up.
+// The list order varies between frames; the edges share one color outside the wave,
+// so only the rounding of overlapping corners can tell.
+
+#include "include/frame.glsl"
+#include "include/edge_shading.glsl"
+
+layout (local_size_x = 64) in;
+
+// Quantization range of the unorm16 positions, in pixels
+uniform vec2 positionOrigin;
+uniform vec2 positionExtent;
+uniform uint recordCount;
+
+// EdgeRecord in bakedScene.h, x in the low and y in the high half of each word
+layout (std430, binding = 0) readonly buffer EdgeRecords {
+    uvec2 records[];
+};
+
+layout (std430, binding = 1) writeonly buffer VisibleRecords {
+    uvec2 visible[];
+};
+
+// modernGL::DrawArraysCommand, count starts at 0 every frame
+layout (std430, binding = 2) buffer DrawCommand {
+    uint vertexCount;
+    uint instanceCount;
+    uint first;
+    uint baseInstance;
+};
+
+vec2 unpackPosition(uint position) {
+    return positionOrigin + vec2(position & 0xFFFFu, position >> 16) / 65535.0 * positionExtent;
+}
+
+// the same tests edgeShade makes, with a pixel of slack for the rounding of the positions
+bool edgeVisible(vec2 a, vec2 b) {
+    if (pointToSegmentDistance(mousePos, a, b) < barrierRadius + 1.0) {
+        return true;
+    }
+#ifdef WAVE_ACTIVE
+    if (abs((a.x + b.x) * 0.5 - waveX) < waveWidth * 0.5 + 1.0) {
+        return true;
+    }
+#endif
+    return false;
+}
+
+void main() {
+    uint index = gl_GlobalInvocationID.x;
+    if (index >= recordCount) {
+        return;
+    }
+
+    uvec2 record = records[index];
+    if (edgeVisible(unpackPosition(record.x), unpackPosition(record.y))) {
+        uint slot = atomicAdd(vertexCount, 6u) / 6u;
+        visible[slot] = record;
+    }
+}
@@ -0,0 +1,14 @@
+#version 330 core
+
+// Vulkan GLSL names the vertex index differently
+#ifdef VULKAN
+#define vertexIndex gl_VertexIndex
+#else
+#define vertexIndex gl_VertexID
+#endif
+
+// One triangle covering the whole screen, no vertex attributes
+void main() {
+    vec2 pos = vec2((vertexIndex << 1) & 2, vertexIndex & 2);
+    gl_Position = vec4(pos * 2.0 - 1.0, 0.0, 1.0);
+}
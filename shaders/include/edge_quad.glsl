@@ -0,0 +1,18 @@
+// Room left on both sides of the quad for the coverage to fade out, only analytic
+// smoothing needs it
+#ifdef ANALYTIC_AA
+const float edgeSmoothingMargin = 1.0;
+#else
+const float edgeSmoothingMargin = 0.0;
+#endif
+
+// Quad corners of the two triangles of an edge: which end, and which side of it
+const int quadEnd[6] = int[6](0, 1, 1, 0, 1, 0);
+const float quadSide[6] = float[6](1.0, 1.0, -1.0, 1.0, -1.0, -1.0);
+
+// corner quadVertex (0-5) of the quad around the segment p1-p2, which must not be empty
+vec2 edgeQuadCorner(vec2 p1, vec2 p2, int quadVertex, float width) {
+    vec2 dir = normalize(p2 - p1);
+    vec2 offset = vec2(-dir.y, dir.x) * (width * 0.5 + edgeSmoothingMargin);
+    return (quadEnd[quadVertex] == 0 ? p1 : p2) + offset * quadSide[quadVertex];
+}
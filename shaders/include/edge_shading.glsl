@@ -0,0 +1,78 @@
+// Edge alpha from the cursor barrier and the wave tint, the same for every render mode.
+// REVERSE_MODE and WAVE_ACTIVE select the variant, see shaderUtils::Feature
+
+#include "frame.glsl"
+
+// Point to segment distance function
+float pointToSegmentDistance(vec2 p, vec2 a, vec2 b) {
+    vec2 ab = b - a;
+    vec2 ap = p - a;
+    float denom = dot(ab, ab);
+    if (denom == 0.0) return length(p - a);
+    float t = dot(ap, ab) / denom;
+    t = clamp(t, 0.0, 1.0);
+    vec2 closest = a + t * ab;
+    return length(p - closest);
+}
+
+// Pixel coverage of a line dist away from the pixel center. With ANALYTIC_AA it is the
+// fraction of a one pixel wide box filter that overlaps the line. Without it the edge
+// quad is exactly as wide as the line, so every fragment is covered and multisampling
+// smooths the sides; shaders without quads always use ANALYTIC_AA
+float edgeCoverage(float dist, float halfLineWidth) {
+#ifdef ANALYTIC_AA
+    return clamp(min(dist + 0.5, halfLineWidth) - max(dist - 0.5, -halfLineWidth), 0.0, 1.0);
+#else
+    return 1.0;
+#endif
+}
+
+// distance from p to the nearest side of the triangle center-a-b, which is returned in e1-e2.
+// Outlines of segments that aren't sides never reach into the triangle
+float nearestTriangleSide(vec2 p, vec2 center, vec2 a, vec2 b, out vec2 e1, out vec2 e2) {
+    e1 = center;
+    e2 = a;
+    float edgeDist = pointToSegmentDistance(p, center, a);
+    float distB = pointToSegmentDistance(p, center, b);
+    if (distB < edgeDist) { edgeDist = distB; e2 = b; }
+    float distAB = pointToSegmentDistance(p, a, b);
+    if (distAB < edgeDist) { edgeDist = distAB; e1 = a; e2 = b; }
+    return edgeDist;
+}
+
+// color and alpha of the segment a-b, before coverage
+vec4 edgeShade(vec2 a, vec2 b, vec4 edgeColor) {
+    float dist = pointToSegmentDistance(mousePos, a, b);
+
+    float alpha = 0.0;
+#ifdef REVERSE_MODE
+    if (dist > barrierRadius + fadeArea) {
+        alpha = edgeColor.a;
+    } else if (dist > barrierRadius) {
+        alpha = ((dist - barrierRadius) / fadeArea) * edgeColor.a;
+    }
+#else
+    if (dist < barrierRadius) {
+        alpha = (1.0 - dist / barrierRadius) * edgeColor.a;
+    }
+#endif
+
+#ifdef WAVE_ACTIVE
+    vec2 midpoint = (a + b) * 0.5;
+    float distToWave = abs(midpoint.x - waveX);
+    float waveThickness = waveWidth * 0.5;
+
+    if (distToWave < waveThickness) {
+        float factor = clamp(1.0 - (distToWave / waveThickness), 0.0, 1.0);
+
+        float wAlpha = waveColor.a * factor;
+        float bAlpha = alpha;
+        alpha = 1.0 - (1.0 - bAlpha) * (1.0 - wAlpha);
+
+        vec3 finalColor = (edgeColor.rgb * bAlpha / alpha) + (waveColor.rgb * wAlpha * (1.0 - bAlpha) / alpha);
+        return vec4(finalColor, alpha);
+    }
+#endif
+
+    return vec4(edgeColor.rgb, alpha);
+}
@@ -0,0 +1,17 @@
+// Per-frame values shared by every program, see FrameBlock in hexScene.h.
+// Vulkan pushes them as constants, the std430 offsets of these members are the std140 ones
+#ifdef VULKAN
+layout (push_constant) uniform Frame {
+#else
+layout (std140) uniform Frame {
+#endif
+    float halfWidth;
+    float halfHeight;
+    vec2 mousePos;       // in window pixels, y up
+    float barrierRadius;
+    float fadeArea;
+    float edgeWidth;     // full width of the edges, quads are wider to leave room for smoothing
+    float waveX;         // only set while a wave is active
+    mediump vec4 waveColor;
+    float waveWidth;
+};
@@ -0,0 +1,33 @@
+#include "hex_shape.glsl"
+
+// Grid layout, matches hexGrid::Layout
+#ifndef VULKAN
+uniform float hexagonWidth;
+uniform float sliceWidth;
+uniform float yDistance;
+#endif
+
+// center of the column nearest to x in the given row, even rows are shifted by half a hexagon
+vec2 rowCenter(int row, float x, out int column) {
+    float rowStart = ((row & 1) != 0) ? 0.0 : sliceWidth;
+    column = int(floor((x - rowStart) / hexagonWidth + 0.5));
+    return vec2(rowStart + float(column) * hexagonWidth, float(row) * yDistance);
+}
+
+// the center of the hexagon p lies in, which is the nearest one of the two rows around p
+vec2 cellCenter(vec2 p, out ivec2 cell) {
+    int row = int(floor(p.y / yDistance));
+    int column0, column1;
+    vec2 center0 = rowCenter(row, p.x, column0);
+    vec2 center1 = rowCenter(row + 1, p.x, column1);
+    bool upper = dot(p - center1, p - center1) < dot(p - center0, p - center0);
+    cell = upper ? ivec2(column1, row + 1) : ivec2(column0, row);
+    return upper ? center1 : center0;
+}
+
+// the triangle (cube face) of the hexagon around center that p lies in, picked by the angle
+int sectorTriangle(vec2 p, vec2 center) {
+    vec2 d = p - center;
+    float angle = degrees(atan(d.y, d.x)) + 30.0;
+    return sectorTriangles[int(floor(mod(angle, 360.0) / 60.0)) % 6];
+}
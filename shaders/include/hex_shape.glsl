@@ -0,0 +1,12 @@
+// Hexagon shape, corners relative to the center. Vulkan has no loose uniforms, the
+// Grid block of procedural_fragment.glsl declares them there
+#ifndef VULKAN
+uniform vec2 corners[6];
+#endif
+
+// The two corners of every triangle (the third one is the center) and its cube face
+const int triangleCorners[12] = int[12](0, 5,  0, 1,  5, 4,  1, 2,  3, 4,  3, 2);
+const int triangleFaces[6] = int[6](0, 0, 1, 2, 1, 2);
+
+// Triangle covering each 60 degree sector, counter-clockwise starting at -30 degrees
+const int sectorTriangles[6] = int[6](3, 1, 0, 2, 4, 5);
@@ -0,0 +1,14 @@
+// Palette crossfade, see palette.h. Colors are mediump everywhere, which only matters on OpenGL ES
+#ifdef VULKAN
+layout (set = 0, binding = 0, std140) uniform Palette {
+#else
+layout (std140) uniform Palette {
+#endif
+    mediump vec4 fromColors[4];  // top, left, right, edge
+    mediump vec4 toColors[4];
+    mediump float paletteFactor;
+};
+
+mediump vec4 paletteColor(int slot) {
+    return mix(fromColors[slot], toColors[slot], paletteFactor);
+}
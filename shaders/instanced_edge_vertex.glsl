@@ -0,0 +1,44 @@
+#version 330 core
+
+#include "include/frame.glsl"
+#include "include/hex_shape.glsl"
+#include "include/palette.glsl"
+#include "include/edge_quad.glsl"
+
+// Per-instance attributes, one record per hexagon
+layout (location = 0) in vec2 aCenter;
+layout (location = 1) in uint aFlags;  // fill mask in bits 0-5, owned borders in bits 6-11
+
+out mediump vec4 vColor;
+out vec2 vEdgeP1;
+out vec2 vEdgeP2;
+
+void main() {
+    int edge = gl_VertexID / 6;
+    int quadVertex = gl_VertexID % 6;
+
+    // edges 0-5 are the spokes, 6-11 the borders (shared ones are drawn by a single hexagon)
+    vec2 p1, p2;
+    if (edge < 6) {
+        p1 = aCenter;
+        p2 = aCenter + corners[edge];
+    } else {
+        int border = edge - 6;
+        p1 = aCenter + corners[border];
+        p2 = aCenter + corners[(border + 1) % 6];
+        if ((aFlags & (1u << uint(edge))) == 0u) {
+            p2 = p1;
+        }
+    }
+
+    vec2 pos = p1;
+    if (p1 != p2) {
+        pos = edgeQuadCorner(p1, p2, quadVertex, edgeWidth);
+    }
+    // borders owned by a neighbour collapse to a point and produce no fragments
+
+    gl_Position = vec4(pos.x / halfWidth - 1.0, pos.y / halfHeight - 1.0, 0.0, 1.0);
+    vColor = paletteColor(3);
+    vEdgeP1 = p1;
+    vEdgeP2 = p2;
+}
@@ -0,0 +1,35 @@
+#version 330 core
+
+#include "include/frame.glsl"
+
+// Sides are pushed out this far so neighbouring triangles overlap, see fillExpansion in hexScene.h
+uniform float fillExpansion;
+
+#include "include/hex_shape.glsl"
+#include "include/palette.glsl"
+
+// Per-instance attributes, one record per hexagon
+layout (location = 0) in vec2 aCenter;
+layout (location = 1) in uint aFlags;  // fill mask in bits 0-5, owned borders in bits 6-11
+
+flat out mediump vec4 vColor;
+
+void main() {
+    int triangle = gl_VertexID / 3;
+    int corner = gl_VertexID % 3;
+
+    vec2 pos = aCenter;
+    if ((aFlags & (1u << uint(triangle))) != 0u) {
+        vec2 a = corners[triangleCorners[triangle * 2]];
+        vec2 b = corners[triangleCorners[triangle * 2 + 1]];
+        vec2 offset = corner == 0 ? vec2(0.0) : (corner == 1 ? a : b);
+
+        // equilateral, so the corners travel twice as far as the sides
+        vec2 middle = (a + b) / 3.0;
+        pos += offset + normalize(offset - middle) * (2.0 * fillExpansion);
+    }
+    // holes collapse onto the center and produce no fragments
+
+    gl_Position = vec4(pos.x / halfWidth - 1.0, pos.y / halfHeight - 1.0, 0.0, 1.0);
+    vColor = paletteColor(triangleFaces[triangle]);
+}
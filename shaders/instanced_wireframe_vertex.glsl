@@ -0,0 +1,29 @@
+#version 330 core
+
+#include "include/frame.glsl"
+#include "include/hex_shape.glsl"
+#include "include/palette.glsl"
+
+// Per-instance attributes, one record per hexagon
+layout (location = 0) in vec2 aCenter;
+layout (location = 1) in uint aFlags;  // fill mask in bits 0-5, owned borders in bits 6-11
+
+out mediump vec4 vColor;
+flat out vec2 vCenter;
+flat out int vTriangle;
+
+void main() {
+    int triangle = gl_VertexID / 3;
+    int corner = gl_VertexID % 3;
+
+    // holes are drawn as well, their outlines still show
+    vec2 pos = aCenter;
+    if (corner > 0) {
+        pos += corners[triangleCorners[triangle * 2 + corner - 1]];
+    }
+
+    gl_Position = vec4(pos.x / halfWidth - 1.0, pos.y / halfHeight - 1.0, 0.0, 1.0);
+    vColor = (aFlags & (1u << uint(triangle))) != 0u ? paletteColor(triangleFaces[triangle]) : vec4(0.0);
+    vCenter = aCenter;
+    vTriangle = triangle;
+}
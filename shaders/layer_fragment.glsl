@@ -0,0 +1,10 @@
+#version 330 core
+
+// A cached layer, premultiplied alpha, same size as the window
+uniform sampler2D layer;
+
+out mediump vec4 FragColor;
+
+void main() {
+    FragColor = texelFetch(layer, ivec2(gl_FragCoord.xy), 0);
+}
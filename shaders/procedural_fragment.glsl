@@ -0,0 +1,73 @@
+#version 330 core
+
+#ifdef VULKAN
+// the uniforms that are loose on GL, see GridBlock in vulkanRenderer.cpp
+layout (set = 0, binding = 1, std140) uniform Grid {
+    vec2 corners[6];
+    float hexagonWidth;
+    float sliceWidth;
+    float yDistance;
+    float screenHeight;
+    uint seed;
+};
+#else
+uniform float screenHeight;
+uniform uint seed;
+#endif
+
+#include "include/hex_grid.glsl"
+#include "include/palette.glsl"
+#include "include/edge_shading.glsl"
+
+out mediump vec4 FragColor;
+
+uint hash(uint x) {
+    x ^= x >> 16;
+    x *= 0x7feb352dU;
+    x ^= x >> 15;
+    x *= 0x846ca68bU;
+    x ^= x >> 16;
+    return x;
+}
+
+// uniform random number in [0, 1) for one triangle of one cell
+float cellRandom(ivec2 cell, int triangle) {
+    uint h = hash(uint(cell.x) ^ hash(uint(cell.y) ^ hash(uint(triangle) ^ seed)));
+    return float(h >> 8) * (1.0 / 16777216.0);
+}
+
+void main() {
+    vec2 p = gl_FragCoord.xy;
+#ifdef VULKAN
+    // Vulkan counts rows from the top, the grid and the cursor are laid out from the bottom
+    p.y = halfHeight * 2.0 - p.y;
+#endif
+
+    ivec2 cell;
+    vec2 center = cellCenter(p, cell);
+    int triangle = sectorTriangle(p, center);
+
+    vec2 a = center + corners[triangleCorners[triangle * 2]];
+    vec2 b = center + corners[triangleCorners[triangle * 2 + 1]];
+
+    // the higher the triangle, the more likely it is left out
+    float normalizedY = ((center.y + a.y + b.y) / 3.0) / screenHeight;
+    float probability = pow(normalizedY, 2.0);
+    vec4 fill = paletteColor(triangleFaces[triangle]);
+    if (cellRandom(cell, triangle) < probability) {
+        fill = vec4(0.0);
+    }
+
+    vec2 e1, e2;
+    float edgeDist = nearestTriangleSide(p, center, a, b, e1, e2);
+    vec4 edge = edgeShade(e1, e2, paletteColor(3));
+    edge.a *= edgeCoverage(edgeDist, edgeWidth * 0.5);
+
+    // edge over fill, the result is blended over the background like the two passes were
+    float alpha = edge.a + fill.a * (1.0 - edge.a);
+    if (alpha <= 0.0) {
+        discard;
+    }
+    vec3 color = (edge.rgb * edge.a + fill.rgb * fill.a * (1.0 - edge.a)) / alpha;
+    FragColor = vec4(color, alpha);
+}
@@ -1,7 +1,7 @@
 #version 330 core
 
-in vec4 vColor;
-out vec4 FragColor;
+flat in mediump vec4 vColor;
+out mediump vec4 FragColor;
 
 void main() {
     FragColor = vColor;
@@ -1,14 +1,21 @@
 #version 330 core
 
-uniform float halfWidth;
-uniform float halfHeight;
+#include "include/frame.glsl"
+
+// Quantization range of the unorm16 positions, in pixels
+uniform vec2 positionOrigin;
+uniform vec2 positionExtent;
+
+#include "include/palette.glsl"
 
 layout (location = 0) in vec2 aPos;
-layout (location = 1) in vec4 aColor;
+layout (location = 1) in uint aFace;
 
-out vec4 vColor;
+// one color per triangle, from its last vertex
+flat out mediump vec4 vColor;
 
 void main() {
-    gl_Position = vec4(aPos.x / halfWidth - 1.0, aPos.y / halfHeight - 1.0, 0.0, 1.0);
-    vColor = aColor;
+    vec2 pos = positionOrigin + aPos * positionExtent;
+    gl_Position = vec4(pos.x / halfWidth - 1.0, pos.y / halfHeight - 1.0, 0.0, 1.0);
+    vColor = paletteColor(int(aFace));
 }
@@ -0,0 +1,34 @@
+#version 330 core
+
+// Fills with their outlines in one pass. Every triangle, holes included, draws the part
+// of its three sides' outlines that lies inside it; the neighbour across a side draws
+// the other half, so no edge geometry is needed.
+
+#include "include/hex_shape.glsl"
+#include "include/palette.glsl"
+#include "include/edge_shading.glsl"
+
+in mediump vec4 vColor; // transparent for holes
+flat in vec2 vCenter;   // center of the hexagon
+flat in int vTriangle;  // index into triangleCorners
+
+out mediump vec4 FragColor;
+
+void main() {
+    vec2 p = gl_FragCoord.xy;
+    vec2 a = vCenter + corners[triangleCorners[vTriangle * 2]];
+    vec2 b = vCenter + corners[triangleCorners[vTriangle * 2 + 1]];
+
+    vec2 e1, e2;
+    float edgeDist = nearestTriangleSide(p, vCenter, a, b, e1, e2);
+    vec4 edge = edgeShade(e1, e2, paletteColor(3));
+    edge.a *= edgeCoverage(edgeDist, edgeWidth * 0.5);
+
+    // edge over fill, blended over the background like the two passes were
+    float alpha = edge.a + vColor.a * (1.0 - edge.a);
+    if (alpha <= 0.0) {
+        discard;
+    }
+    vec3 color = (edge.rgb * edge.a + vColor.rgb * vColor.a * (1.0 - edge.a)) / alpha;
+    FragColor = vec4(color, alpha);
+}
@@ -0,0 +1,30 @@
+#version 330 core
+
+#include "include/frame.glsl"
+
+// Quantization range of the unorm16 positions, in pixels
+uniform vec2 positionOrigin;
+uniform vec2 positionExtent;
+
+#include "include/hex_shape.glsl"
+#include "include/palette.glsl"
+
+layout (location = 0) in vec2 aPos;
+layout (location = 1) in uvec3 aTriangle;  // cube face, index into triangleCorners, filled
+
+out mediump vec4 vColor;
+flat out vec2 vCenter;
+flat out int vTriangle;
+
+void main() {
+    vec2 pos = positionOrigin + aPos * positionExtent;
+    gl_Position = vec4(pos.x / halfWidth - 1.0, pos.y / halfHeight - 1.0, 0.0, 1.0);
+
+    // triangles are baked as center, first corner, second corner
+    int triangle = int(aTriangle.y);
+    int corner = gl_VertexID % 3;
+    vCenter = corner == 0 ? pos : pos - corners[triangleCorners[triangle * 2 + corner - 1]];
+    vTriangle = triangle;
+
+    vColor = aTriangle.z != 0u ? paletteColor(int(aTriangle.x)) : vec4(0.0);
+}
@@ -0,0 +1,623 @@
+#include "bakedScene.h"
+#include "utils.h"
+#include "palette.h"
+#include "glState.h"
+#include "edgeGrid.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+
+
+static std::uint16_t quantize(float value, float origin, float extent) {
+    float normalized = std::clamp((value - origin) / extent, 0.0f, 1.0f);
+    return static_cast<std::uint16_t>(std::lround(normalized * 65535.0f));
+}
+
+// Outside single pass mode a hexagon is its center followed by its six corners. The color is
+// flat, taken from the last vertex of each triangle, and every face has a corner it alone ends on
+static constexpr std::array<hexGrid::Corner, hexGrid::FaceCount> faceCorners{ hexGrid::Top, hexGrid::LeftBottom, hexGrid::RightBottom };
+
+// 3 per triangle of the hexagon whose center is vertex base, holes collapse onto the center
+static void appendHexagonIndices(const hexGrid::Hexagon& hexagon, GLuint base, std::vector<GLuint>& indices) {
+    for (size_t i = 0; i < hexGrid::triangles.size(); i++) {
+        if ((hexagon.fillMask & (1u << i)) == 0) {
+            indices.insert(indices.end(), { base, base, base });
+            continue;
+        }
+        const hexGrid::Triangle& triangle = hexGrid::triangles[i];
+        const GLuint last = faceCorners[triangle.face];
+        const GLuint other = triangle.a == faceCorners[triangle.face] ? triangle.b : triangle.a;
+        indices.insert(indices.end(), { base, base + 1 + other, base + 1 + last });
+    }
+}
+
+// single pass mode, 3 per triangle of the hexagon
+static void appendSinglePassFlags(const hexGrid::Hexagon& hexagon, std::vector<VertexFlags>& flags) {
+    for (size_t i = 0; i < hexGrid::triangles.size(); i++) {
+        std::uint8_t filled = (hexagon.fillMask & (1u << i)) != 0 ? 1 : 0;
+        flags.insert(flags.end(), 3, VertexFlags(static_cast<std::uint8_t>(hexGrid::triangles[i].face), static_cast<std::uint8_t>(i), filled));
+    }
+}
+
+std::unique_ptr<BakedScene> BakedScene::create(const Settings& settings, const hexGrid::Layout& layout, const std::vector<hexGrid::Hexagon>& hexagons) {
+    std::unique_ptr<BakedScene> scene(new BakedScene(settings));
+
+    // ---------- compile shaders ----------
+    // the quads leave room for analytic smoothing only when there are no samples to do it
+    const bool analyticAA = settings.MSAA == 0;
+
+    if (settings.singlePass) {
+        // the outlines are computed per pixel, there are no quads to multisample
+        scene->edgePrograms = EdgePrograms::create(settings, "wireframe_vertex.glsl", "wireframe_fragment.glsl", true);
+        if (!scene->edgePrograms) {
+            std::cerr << "Failed to compile wireframe shaders!" << std::endl;
+            return nullptr;
+        }
+    } else {
+        scene->staticShaderProgram = shaderUtils::compileShaders("static_vertex.glsl", "static_fragment.glsl");
+        if (scene->staticShaderProgram == 0) {
+            std::cerr << "Failed to compile static shaders!" << std::endl;
+            return nullptr;
+        }
+
+        scene->edgePrograms = EdgePrograms::create(settings, "edge_vertex.glsl", "edge_fragment.glsl", analyticAA);
+        if (!scene->edgePrograms) {
+            std::cerr << "Failed to compile edge shaders!" << std::endl;
+            return nullptr;
+        }
+    }
+
+    if (settings.layerCache && settings.barrier.reverse && !settings.singlePass) {
+        scene->edgeCoverageProgram = shaderUtils::compileShaders("edge_vertex.glsl", "edge_coverage_fragment.glsl",
+                                                                 analyticAA ? std::uint32_t{shaderUtils::FeatureAnalyticAA} : 0u);
+        if (scene->edgeCoverageProgram == 0) {
+            std::cerr << "Failed to compile edge coverage shaders!" << std::endl;
+            return nullptr;
+        }
+    }
+
+    // outside reverse mode most edges are invisible, a compute pass picks the others every frame
+    if (settings.indirectDraw && modernGL::computeAvailable() && !settings.barrier.reverse && !settings.singlePass) {
+        scene->cullStill = shaderUtils::compileComputeShader("edge_cull_compute.glsl");
+        scene->cullWave = shaderUtils::compileComputeShader("edge_cull_compute.glsl", shaderUtils::FeatureWave);
+        if (scene->cullStill == 0 || scene->cullWave == 0) {
+            std::cerr << "Failed to compile edge culling shaders, drawing every edge" << std::endl;
+            glState::deleteProgram(scene->cullStill);
+            glState::deleteProgram(scene->cullWave);
+            scene->cullStill = scene->cullWave = 0;
+        }
+    }
+
+    // ---------- quantization range: every corner, edge quads are expanded in the shader ----------
+    glm::vec2 boundsMin(0.0f), boundsMax(0.0f);
+    if (!hexagons.empty()) {
+        boundsMin = boundsMax = hexagons.front().center;
+        for (const hexGrid::Hexagon& hexagon : hexagons) {
+            boundsMin = glm::min(boundsMin, hexagon.center);
+            boundsMax = glm::max(boundsMax, hexagon.center);
+        }
+    }
+    const float expansion = fillExpansion(settings);
+    glm::vec2 margin = glm::vec2(layout.sliceWidth, layout.size) + expansion * 2.0f;
+    const glm::vec2 positionOrigin = boundsMin - margin;
+    const glm::vec2 positionExtent = (boundsMax + margin) - positionOrigin;
+
+    if (scene->staticShaderProgram != 0) {
+        scene->uploadConstants(scene->staticShaderProgram, layout, positionOrigin, positionExtent);
+    }
+    scene->edgePrograms->forEachProgram([&](GLuint program) {
+        scene->uploadConstants(program, layout, positionOrigin, positionExtent);
+    });
+    if (scene->edgeCoverageProgram != 0) {
+        scene->uploadConstants(scene->edgeCoverageProgram, layout, positionOrigin, positionExtent);
+    }
+    for (GLuint program : { scene->cullStill, scene->cullWave }) {
+        if (program != 0) {
+            scene->uploadConstants(program, layout, positionOrigin, positionExtent);
+        }
+    }
+
+    auto pack = [&](const glm::vec2& p) -> PackedPosition {
+        return { quantize(p.x, positionOrigin.x, positionExtent.x), quantize(p.y, positionOrigin.y, positionExtent.y) };
+    };
+
+    // ---------- geometry storage ----------
+    // fills in two streams, the positions never change after this
+    std::vector<PackedPosition> trianglePositions; // the center and corners of every hexagon outside single pass mode
+    std::vector<VertexFlags> triangleFlags;
+    std::vector<GLuint> triangleIndices;  // 3 per triangle, holes included, empty in single pass mode
+    std::vector<EdgeRecord> edgeRecords;  // one per outline segment
+
+    const size_t vertexEstimate = hexagons.size() * (settings.singlePass ? singlePassVerticesPerHexagon : indexedVerticesPerHexagon);
+    trianglePositions.reserve(vertexEstimate);
+    triangleFlags.reserve(vertexEstimate);
+    if (!settings.singlePass) {
+        triangleIndices.reserve(hexagons.size() * indicesPerHexagon);
+        edgeRecords.reserve(hexagons.size() * 12); // up to 6 spokes and 6 borders
+    }
+
+    // ---------- helpers to add geometry ----------
+    auto addVertex = [&](const PackedPosition& position, std::uint8_t face, std::uint8_t triangle, std::uint8_t filled) {
+        trianglePositions.push_back(position);
+        triangleFlags.emplace_back(face, triangle, filled);
+    };
+
+    // moving a corner out from the center by this much moves both its sides out by the expansion
+    const float cornerExpansion = expansion * 2.0f / std::sqrt(3.0f);
+
+    // single pass triangles must meet exactly, each one draws its half of the shared outline
+    // the flags are added per hexagon by appendSinglePassFlags()
+    auto addTriangleStatic = [&](const glm::vec2& p1, const glm::vec2& p2, const glm::vec2& p3) {
+        trianglePositions.push_back(pack(p1));
+        trianglePositions.push_back(pack(p2));
+        trianglePositions.push_back(pack(p3));
+    };
+
+    // Otherwise the triangles of a hexagon share its center and corners. The corners move out
+    // so the borders between neighbouring hexagons overlap by the expansion, the sides towards
+    // a hole stay where they are. Every triangle, holes included, keeps its 3 indices, so
+    // refill() only rewrites the index buffer
+    auto addHexagonIndexed = [&](const hexGrid::Hexagon& hexagon) {
+        const GLuint base = static_cast<GLuint>(trianglePositions.size());
+        addVertex(pack(hexagon.center), 0, 0, 1);
+        for (int k = 0; k < hexGrid::CornerCount; k++) {
+            auto face = std::find(faceCorners.begin(), faceCorners.end(), k);
+            std::uint8_t faceIndex = static_cast<std::uint8_t>(face != faceCorners.end() ? face - faceCorners.begin() : 0);
+            glm::vec2 corner = layout.corners[k];
+            addVertex(pack(hexagon.center + corner + glm::normalize(corner) * cornerExpansion), faceIndex, 0, 1);
+        }
+        appendHexagonIndices(hexagon, base, triangleIndices);
+    };
+
+    // without GPU culling the edges are grouped by screen cell outside reverse mode, by their midpoints
+    const bool gridEdges = !settings.singlePass && !settings.barrier.reverse && scene->cullStill == 0;
+    std::vector<glm::vec2> edgeMidpoints;
+    if (gridEdges) {
+        edgeMidpoints.reserve(edgeRecords.capacity());
+    }
+
+    auto addEdge = [&](const glm::vec2& p1, const glm::vec2& p2) {
+        edgeRecords.push_back({ pack(p1), pack(p2) });
+        if (gridEdges) {
+            edgeMidpoints.push_back((p1 + p2) * 0.5f);
+        }
+    };
+
+    // along a space-filling curve rather than by rows, neighbouring triangles land in the
+    // same rasterizer tiles close together and vertices close together in the buffer
+    scene->bakeOrder = hexGrid::curveOrder(layout, hexagons);
+    scene->hexagonSlots.resize(hexagons.size());
+    for (size_t slot = 0; slot < scene->bakeOrder.size(); slot++) {
+        const std::uint32_t index = scene->bakeOrder[slot];
+        const hexGrid::Hexagon& hexagon = hexagons[index];
+        scene->hexagonSlots[index] = static_cast<std::uint32_t>(slot);
+
+        if (!settings.singlePass) {
+            addHexagonIndexed(hexagon);
+        } else {
+            // holes are baked as well, they draw outlines, and refill() only flips their flags
+            for (size_t i = 0; i < hexGrid::triangles.size(); i++) {
+                const hexGrid::Triangle& triangle = hexGrid::triangles[i];
+                glm::vec2 p1 = hexagon.center;
+                glm::vec2 p2 = hexagon.center + layout.corners[triangle.a];
+                glm::vec2 p3 = hexagon.center + layout.corners[triangle.b];
+                addTriangleStatic(p1, p2, p3);
+            }
+            appendSinglePassFlags(hexagon, triangleFlags);
+            continue;
+        }
+
+        // every segment is emitted once: the spokes, and the borders this hexagon owns
+        for (int k = 0; k < hexGrid::spokeCount; k++) {
+            addEdge(hexagon.center, hexagon.center + layout.corners[k]);
+        }
+        for (int k = 0; k < hexGrid::borderCount; k++) {
+            if (hexagon.borderMask & (1u << k)) {
+                glm::vec2 p1 = hexagon.center + layout.corners[k];
+                glm::vec2 p2 = hexagon.center + layout.corners[(k + 1) % hexGrid::CornerCount];
+                addEdge(p1, p2);
+            }
+        }
+    }
+
+    // ---------- edge records in cell order, every cell one range of the buffer ----------
+    if (gridEdges) {
+        // a few hexagons per cell, small enough that the cursor circle leaves most rows out
+        scene->edgeGrid = std::make_unique<EdgeGrid>(static_cast<int>(layout.screenWidth), static_cast<int>(layout.screenHeight),
+                                                     std::max(layout.size * 2.0f, 32.0f));
+        std::vector<std::uint32_t> order = scene->edgeGrid->build(edgeMidpoints);
+
+        std::vector<EdgeRecord> sortedRecords;
+        sortedRecords.reserve(edgeRecords.size());
+        for (std::uint32_t index : order) {
+            sortedRecords.push_back(edgeRecords[index]);
+        }
+        edgeRecords.swap(sortedRecords);
+
+        // a segment is within half its length of its midpoint, plus a pixel for the quantization
+        scene->gridCursorReach = settings.barrier.radius + layout.size * 0.5f + 1.0f;
+        scene->gridWaveReach = settings.wave.width * 0.5f + 1.0f;
+    }
+
+    scene->triangleVertexCount = static_cast<GLsizei>(trianglePositions.size());
+    scene->triangleIndexCount = static_cast<GLsizei>(triangleIndices.size());
+    scene->edgeVertexCount = static_cast<GLsizei>(edgeRecords.size() * 6);
+
+    if (settings.indirectDraw && modernGL::available()) {
+        scene->createIndirect(trianglePositions, triangleFlags, triangleIndices, edgeRecords);
+        return scene;
+    }
+
+    // ---------- Create VBOs, the vertex arrays come from createVertexArrays() ----------
+    glGenBuffers(1, &scene->positionBuffer);
+    glGenBuffers(1, &scene->flagBuffer);
+
+    // position (location 0) unorm16 vec2
+    glBindBuffer(GL_ARRAY_BUFFER, scene->positionBuffer);
+    if (!trianglePositions.empty()) {
+        glBufferData(GL_ARRAY_BUFFER,
+                     trianglePositions.size() * sizeof(PackedPosition),
+                     trianglePositions.data(),
+                     GL_STATIC_DRAW);
+    } else {
+        // ensure there's at least an empty buffer
+        glBufferData(GL_ARRAY_BUFFER, 1, nullptr, GL_STATIC_DRAW);
+    }
+
+    // cube face, triangle index and filled flag (location 1), rewritten by refill() in single pass mode
+    glBindBuffer(GL_ARRAY_BUFFER, scene->flagBuffer);
+    const GLenum flagUsage = settings.singlePass ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW;
+    if (!triangleFlags.empty()) {
+        glBufferData(GL_ARRAY_BUFFER, triangleFlags.size() * sizeof(VertexFlags), triangleFlags.data(), flagUsage);
+    } else {
+        glBufferData(GL_ARRAY_BUFFER, 1, nullptr, flagUsage);
+    }
+
+    // uploaded through the array binding, the element binding belongs to a vertex array;
+    // refill() rewrites it
+    if (!triangleIndices.empty()) {
+        glGenBuffers(1, &scene->staticEBO);
+        glBindBuffer(GL_ARRAY_BUFFER, scene->staticEBO);
+        glBufferData(GL_ARRAY_BUFFER,
+                     triangleIndices.size() * sizeof(GLuint),
+                     triangleIndices.data(),
+                     GL_DYNAMIC_DRAW);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    // the outlines were part of the fill pass
+    if (settings.singlePass) {
+        return scene;
+    }
+
+    // Edge records in a buffer texture, read as two unorm16 endpoints per texel
+    glGenBuffers(1, &scene->edgeBuffer);
+    glBindBuffer(GL_TEXTURE_BUFFER, scene->edgeBuffer);
+    if (!edgeRecords.empty()) {
+        glBufferData(GL_TEXTURE_BUFFER,
+                     edgeRecords.size() * sizeof(EdgeRecord),
+                     edgeRecords.data(),
+                     GL_STATIC_DRAW);
+    } else {
+        glBufferData(GL_TEXTURE_BUFFER, sizeof(EdgeRecord), nullptr, GL_STATIC_DRAW);
+    }
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+    glGenTextures(1, &scene->edgeTexture);
+    glBindTexture(GL_TEXTURE_BUFFER, scene->edgeTexture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA16, scene->edgeBuffer);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+
+    return scene;
+}
+
+void BakedScene::createVertexArrays() {
+    if (geometryBuffer != 0) {
+        // ---------- described without binding them ----------
+        modernGL::createVertexArrays(1, &staticVAO);
+        modernGL::vertexArrayVertexBuffer(staticVAO, 0, geometryBuffer, 0, sizeof(PackedPosition));
+        modernGL::vertexArrayVertexBuffer(staticVAO, 1, flagBuffer, 0, sizeof(VertexFlags));
+
+        modernGL::vertexArrayAttribFormat(staticVAO, 0, 2, GL_UNSIGNED_SHORT, GL_TRUE, 0);
+        modernGL::vertexArrayAttribBinding(staticVAO, 0, 0);
+        modernGL::enableVertexArrayAttrib(staticVAO, 0);
+
+        modernGL::vertexArrayAttribIFormat(staticVAO, 1, 3, GL_UNSIGNED_BYTE, offsetof(VertexFlags, face));
+        modernGL::vertexArrayAttribBinding(staticVAO, 1, 1);
+        modernGL::enableVertexArrayAttrib(staticVAO, 1);
+
+        if (!settings.singlePass) {
+            modernGL::vertexArrayElementBuffer(staticVAO, geometryBuffer);
+            // draws the command buffer, everything else is pulled through the texture
+            modernGL::createVertexArrays(1, &edgeVAO);
+        }
+        return;
+    }
+
+    glGenVertexArrays(1, &staticVAO);
+    glState::bindVertexArray(staticVAO);
+
+    // layout: position (location 0) unorm16 vec2
+    glBindBuffer(GL_ARRAY_BUFFER, positionBuffer);
+    glVertexAttribPointer(0, 2, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(PackedPosition), (void*)0);
+    glEnableVertexAttribArray(0);
+
+    // layout: cube face, triangle index and filled flag (location 1) uvec3,
+    // static_vertex.glsl only reads the face
+    glBindBuffer(GL_ARRAY_BUFFER, flagBuffer);
+    glVertexAttribIPointer(1, 3, GL_UNSIGNED_BYTE, sizeof(VertexFlags), (void*)offsetof(VertexFlags, face));
+    glEnableVertexAttribArray(1);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    if (staticEBO != 0) {
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, staticEBO);
+    }
+
+    // core profile draws need a vertex array even without attributes
+    if (!settings.singlePass) {
+        glGenVertexArrays(1, &edgeVAO);
+    }
+}
+
+void BakedScene::createIndirect(const std::vector<PackedPosition>& trianglePositions, const std::vector<VertexFlags>& triangleFlags,
+                                const std::vector<GLuint>& triangleIndices, const std::vector<EdgeRecord>& edgeRecords) {
+    // ---------- one buffer: positions, indices, and the edge records where a buffer texture (and the culling's storage buffer) may begin ----------
+    GLint textureAlignment = 1, storageAlignment = 1;
+    glGetIntegerv(GL_TEXTURE_BUFFER_OFFSET_ALIGNMENT, &textureAlignment);
+    if (cullStill != 0) {
+        glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &storageAlignment);
+    }
+    const size_t alignment = static_cast<size_t>(std::max({ textureAlignment, storageAlignment, 1 }));
+
+    const size_t triangleBytes = trianglePositions.size() * sizeof(PackedPosition); // a multiple of the index size
+    const size_t indexBytes = triangleIndices.size() * sizeof(GLuint);
+    const size_t edgeOffset = (triangleBytes + indexBytes + alignment - 1) / alignment * alignment;
+    const size_t edgeBytes = std::max<size_t>(edgeRecords.size(), 1) * sizeof(EdgeRecord);
+
+    std::vector<std::uint8_t> storage(edgeOffset + edgeBytes, 0);
+    if (triangleBytes > 0) {
+        std::memcpy(storage.data(), trianglePositions.data(), triangleBytes);
+    }
+    if (indexBytes > 0) {
+        std::memcpy(storage.data() + triangleBytes, triangleIndices.data(), indexBytes);
+    }
+    if (!edgeRecords.empty()) {
+        std::memcpy(storage.data() + edgeOffset, edgeRecords.data(), edgeRecords.size() * sizeof(EdgeRecord));
+    }
+
+    // only the indices are written after the upload, by refill()
+    modernGL::createBuffers(1, &geometryBuffer);
+    modernGL::namedBufferStorage(geometryBuffer, static_cast<GLsizeiptr>(storage.size()), storage.data(),
+                                 settings.singlePass ? 0 : GL_DYNAMIC_STORAGE_BIT);
+    indexOffset = static_cast<GLintptr>(triangleBytes);
+
+    // the flags on their own, refill() rewrites them in single pass mode
+    modernGL::createBuffers(1, &flagBuffer);
+    modernGL::namedBufferStorage(flagBuffer, static_cast<GLsizeiptr>(std::max<size_t>(triangleFlags.size(), 1) * sizeof(VertexFlags)),
+                                 triangleFlags.empty() ? nullptr : triangleFlags.data(), settings.singlePass ? GL_DYNAMIC_STORAGE_BIT : 0);
+
+    if (!settings.singlePass) {
+        modernGL::createTextures(GL_TEXTURE_BUFFER, 1, &edgeTexture);
+        modernGL::textureBufferRange(edgeTexture, GL_RGBA16, geometryBuffer, static_cast<GLintptr>(edgeOffset), static_cast<GLsizeiptr>(edgeBytes));
+    }
+
+    // ---------- one command per pass, rewritten by whatever decides what is drawn ----------
+    const modernGL::DrawArraysCommand commands[] = {
+        { static_cast<GLuint>(triangleVertexCount), 1, 0, 0 },
+        { static_cast<GLuint>(edgeVertexCount), 1, 0, 0 },
+    };
+    drawCommands = std::make_unique<modernGL::DrawCommandBuffer>(2);
+    drawCommands->set(fillCommand, commands, 2);
+
+    // the indexed fills need the other command layout, the first index counts from the start of the buffer
+    if (!settings.singlePass) {
+        const modernGL::DrawElementsCommand fills{ static_cast<GLuint>(triangleIndexCount), 1,
+                                                   static_cast<GLuint>(triangleBytes / sizeof(GLuint)), 0, 0 };
+        fillElementCommand = std::make_unique<modernGL::ElementCommandBuffer>(1);
+        fillElementCommand->set(0, &fills, 1);
+    }
+
+    // ---------- culling output, as large as if every edge passed ----------
+    if (cullStill != 0) {
+        edgeRecordOffset = static_cast<GLintptr>(edgeOffset);
+        edgeRecordBytes = static_cast<GLsizeiptr>(edgeBytes);
+
+        modernGL::createBuffers(1, &visibleBuffer);
+        modernGL::namedBufferStorage(visibleBuffer, edgeRecordBytes, nullptr, 0);
+        modernGL::createTextures(GL_TEXTURE_BUFFER, 1, &visibleTexture);
+        modernGL::textureBufferRange(visibleTexture, GL_RGBA16, visibleBuffer, 0, edgeRecordBytes);
+
+        culledCommand = std::make_unique<modernGL::DrawCommandBuffer>(1);
+
+        for (GLuint program : { cullStill, cullWave }) {
+            glState::useProgram(program);
+            glUniform1ui(glGetUniformLocation(program, "recordCount"), static_cast<GLuint>(edgeRecords.size()));
+        }
+    }
+}
+
+void BakedScene::selectEdgeCells(const FrameState& frame) {
+    if (hasCulled && frame == culledFrame) {
+        return;
+    }
+
+    edgeGrid->query(frame.mousePos, gridCursorReach, frame.waveProgress >= 0.0f, frame.waveX, gridWaveReach, visibleRanges);
+    for (size_t i = 0; i < visibleRanges.firsts.size(); i++) {
+        visibleRanges.firsts[i] *= 6;
+        visibleRanges.counts[i] *= 6;
+    }
+
+    culledFrame = frame;
+    hasCulled = true;
+}
+
+void BakedScene::cullEdges(const FrameState& frame) {
+    if (hasCulled && frame == culledFrame) {
+        return;
+    }
+
+    const modernGL::DrawArraysCommand empty{ 0, 1, 0, 0 };
+    culledCommand->set(0, &empty, 1);
+
+    glState::useProgram(frame.waveProgress >= 0.0f ? cullWave : cullStill);
+    glBindBufferRange(GL_SHADER_STORAGE_BUFFER, 0, geometryBuffer, edgeRecordOffset, edgeRecordBytes);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 1, visibleBuffer);
+    glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, culledCommand->buffer());
+
+    const GLuint recordCount = static_cast<GLuint>(edgeVertexCount / 6);
+    modernGL::dispatchCompute((recordCount + 63) / 64, 1, 1);
+
+    // the draw reads the count from the command and the records through the texture
+    modernGL::memoryBarrier(GL_COMMAND_BARRIER_BIT | GL_TEXTURE_FETCH_BARRIER_BIT);
+
+    culledFrame = frame;
+    hasCulled = true;
+}
+
+BakedScene::~BakedScene() {
+    glState::deleteProgram(staticShaderProgram);
+    glState::deleteProgram(edgeCoverageProgram);
+
+    glState::deleteVertexArray(staticVAO);
+    glDeleteBuffers(1, &positionBuffer);
+    glDeleteBuffers(1, &flagBuffer);
+    glDeleteBuffers(1, &staticEBO);
+    glState::deleteVertexArray(edgeVAO);
+    glDeleteTextures(1, &edgeTexture);
+    glDeleteBuffers(1, &edgeBuffer);
+    glDeleteBuffers(1, &geometryBuffer);
+
+    glState::deleteProgram(cullStill);
+    glState::deleteProgram(cullWave);
+    glDeleteTextures(1, &visibleTexture);
+    glDeleteBuffers(1, &visibleBuffer);
+}
+
+bool BakedScene::refill(const std::vector<hexGrid::Hexagon>& hexagons, size_t first, size_t count) {
+    count = first < hexagonSlots.size() ? std::min(count, hexagonSlots.size() - first) : 0;
+    if (count == 0) {
+        return true;
+    }
+
+    // the hexagons were baked in curve order, the changed ones lie somewhere in one run of slots
+    std::uint32_t firstSlot = hexagonSlots[first], lastSlot = hexagonSlots[first];
+    for (size_t index = first; index < first + count; index++) {
+        firstSlot = std::min(firstSlot, hexagonSlots[index]);
+        lastSlot = std::max(lastSlot, hexagonSlots[index]);
+    }
+
+    // rebuilt as a whole and sent in one upload, the others in between come out as they were
+    auto upload = [&](GLuint buffer, GLintptr offset, const auto& values) {
+        const GLsizeiptr bytes = static_cast<GLsizeiptr>(values.size() * sizeof(values[0]));
+        if (geometryBuffer != 0) {
+            modernGL::namedBufferSubData(buffer, offset, bytes, values.data());
+        } else {
+            // through the array binding, like the upload in create()
+            glBindBuffer(GL_ARRAY_BUFFER, buffer);
+            glBufferSubData(GL_ARRAY_BUFFER, offset, bytes, values.data());
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+        }
+    };
+
+    if (settings.singlePass) {
+        std::vector<VertexFlags> flags;
+        flags.reserve((lastSlot + 1 - firstSlot) * singlePassVerticesPerHexagon);
+        for (std::uint32_t slot = firstSlot; slot <= lastSlot; slot++) {
+            appendSinglePassFlags(hexagons[bakeOrder[slot]], flags);
+        }
+        upload(flagBuffer, static_cast<GLintptr>(firstSlot * singlePassVerticesPerHexagon * sizeof(VertexFlags)), flags);
+    } else {
+        std::vector<GLuint> indices;
+        indices.reserve((lastSlot + 1 - firstSlot) * indicesPerHexagon);
+        for (std::uint32_t slot = firstSlot; slot <= lastSlot; slot++) {
+            appendHexagonIndices(hexagons[bakeOrder[slot]], static_cast<GLuint>(slot * indexedVerticesPerHexagon), indices);
+        }
+        upload(geometryBuffer != 0 ? geometryBuffer : staticEBO,
+               indexOffset + static_cast<GLintptr>(firstSlot * indicesPerHexagon * sizeof(GLuint)), indices);
+    }
+    return true;
+}
+
+void BakedScene::uploadConstants(GLuint program, const hexGrid::Layout& layout, const glm::vec2& positionOrigin, const glm::vec2& positionExtent) const {
+    glState::useProgram(program);
+
+    glUniform2f(glGetUniformLocation(program, "positionOrigin"), positionOrigin.x, positionOrigin.y);
+    glUniform2f(glGetUniformLocation(program, "positionExtent"), positionExtent.x, positionExtent.y);
+    glUniform2fv(glGetUniformLocation(program, "corners"), hexGrid::CornerCount, &layout.corners[0].x);
+    glUniform1i(glGetUniformLocation(program, "edgeRecords"), 0);
+    bindPaletteBlock(program);
+    bindFrameBlock(program);
+}
+
+void BakedScene::drawFills(const FrameState& frame) {
+    if (settings.singlePass) {
+        edgePrograms->use(frame);
+    } else {
+        glState::useProgram(staticShaderProgram);
+    }
+
+    glState::bindVertexArray(staticVAO);
+    if (fillElementCommand) {
+        fillElementCommand->draw(GL_TRIANGLES, 0, 1);
+    } else if (drawCommands) {
+        drawCommands->draw(GL_TRIANGLES, fillCommand, 1);
+    } else if (!settings.singlePass) {
+        glDrawElements(GL_TRIANGLES, triangleIndexCount, GL_UNSIGNED_INT, nullptr);
+    } else {
+        glDrawArrays(GL_TRIANGLES, 0, triangleVertexCount);
+    }
+}
+
+void BakedScene::drawEdges(const FrameState& frame) {
+    if (settings.singlePass) {
+        return;
+    }
+
+    if (culledCommand) {
+        cullEdges(frame);
+
+        edgePrograms->use(frame);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_BUFFER, visibleTexture);
+        glState::bindVertexArray(edgeVAO);
+        culledCommand->draw(GL_TRIANGLES, 0, 1);
+        glBindTexture(GL_TEXTURE_BUFFER, 0);
+        return;
+    }
+
+    if (edgeGrid) {
+        selectEdgeCells(frame);
+    }
+
+    edgePrograms->use(frame);
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_BUFFER, edgeTexture);
+    glState::bindVertexArray(edgeVAO);
+    if (edgeGrid) {
+        glMultiDrawArrays(GL_TRIANGLES, visibleRanges.firsts.data(), visibleRanges.counts.data(),
+                          static_cast<GLsizei>(visibleRanges.firsts.size()));
+    } else if (drawCommands) {
+        drawCommands->draw(GL_TRIANGLES, edgeCommand, 1);
+    } else {
+        glDrawArrays(GL_TRIANGLES, 0, edgeVertexCount);
+    }
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+}
+
+void BakedScene::drawEdgeCoverage(const FrameState& frame) {
+    glState::useProgram(edgeCoverageProgram);
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_BUFFER, edgeTexture);
+    glState::bindVertexArray(edgeVAO);
+    if (drawCommands) {
+        drawCommands->draw(GL_TRIANGLES, edgeCommand, 1);
+    } else {
+        glDrawArrays(GL_TRIANGLES, 0, edgeVertexCount);
+    }
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+}
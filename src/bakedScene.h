@@ -0,0 +1,126 @@
+#pragma once
+
+#include <cstdint>
+
+#include "hexScene.h"
+#include "modernGL.h"
+#include "edgeGrid.h"
+
+// Positions are stored as unorm16 across the bounds of the grid (about 0.2 px
+// per step on a 3x4K wall). Corners shared by neighbouring triangles quantize
+// to the same value, so no cracks open up between them.
+struct PackedPosition {
+    std::uint16_t x;
+    std::uint16_t y;
+};
+
+// The rest of a triangle vertex, 4 bytes. Kept in a stream of its own next to the
+// positions, so changing fills rewrites these and leaves the positions alone
+struct VertexFlags {
+    std::uint8_t face;     // index into the cube colors
+    std::uint8_t triangle; // index into hexGrid::triangles, for outlines drawn in the fill pass
+    std::uint8_t filled;   // 0 for holes, only read in single pass mode
+    std::uint8_t padding;
+
+    VertexFlags(std::uint8_t face, std::uint8_t triangle, std::uint8_t filled)
+        : face(face), triangle(triangle), filled(filled), padding(0) {}
+};
+
+// One outline segment, 8 bytes. The edge vertex shader pulls it from a buffer
+// texture by gl_VertexID / 6 and expands the quad itself, so the width is a
+// uniform and the color is the same for every edge
+struct EdgeRecord {
+    PackedPosition p1;
+    PackedPosition p2;
+};
+
+// Every triangle baked on the CPU and uploaded once, as the center and corners of every
+// hexagon plus an index buffer where holes are degenerate, with one record per outline
+// segment. Hexagons follow a Hilbert curve rather than scanlines. In single pass mode every
+// triangle is baked unindexed instead and draws its own outlines, there is no edge geometry
+// at all. Positions and the remaining vertex flags are separate streams.
+// With indirect-draw on a GL 4.5 context the fills and edge records share one buffer
+// built with direct state access, and every pass draws from a command buffer. Outside
+// reverse mode a compute pass then keeps only the edges near the cursor and the wave.
+// Without it the edge records are sorted into an EdgeGrid instead, and only the cells
+// near the cursor and the wave are drawn.
+class BakedScene : public HexScene {
+public:
+    static std::unique_ptr<BakedScene> create(const Settings& settings, const hexGrid::Layout& layout, const std::vector<hexGrid::Hexagon>& hexagons);
+    ~BakedScene() override;
+
+    void createVertexArrays() override;
+
+    void drawFills(const FrameState& frame) override;
+    void drawEdges(const FrameState& frame) override;
+    void drawEdgeCoverage(const FrameState& frame) override;
+
+    bool cacheableFills() const override { return !settings.singlePass; }
+    bool edgesInFillPass() const override { return settings.singlePass; }
+
+    // rewrites the indices, or the flags in single pass mode, in one upload
+    bool refill(const std::vector<hexGrid::Hexagon>& hexagons, size_t first, size_t count) override;
+
+private:
+    explicit BakedScene(const Settings& settings) : settings(settings) {}
+
+    // the quantization range never changes, it is set once after linking
+    void uploadConstants(GLuint program, const hexGrid::Layout& layout, const glm::vec2& positionOrigin, const glm::vec2& positionExtent) const;
+
+    // uploads the geometry for the indirect path
+    void createIndirect(const std::vector<PackedPosition>& trianglePositions, const std::vector<VertexFlags>& triangleFlags,
+                        const std::vector<GLuint>& triangleIndices, const std::vector<EdgeRecord>& edgeRecords);
+
+    // fills visibleBuffer and culledCommand with the edges that can show up in frame
+    void cullEdges(const FrameState& frame);
+    // fills visibleRanges with the cells whose edges can show up in frame
+    void selectEdgeCells(const FrameState& frame);
+
+    const Settings& settings;
+
+    GLuint staticShaderProgram = 0; // not used in single pass mode
+    GLuint edgeCoverageProgram = 0;
+    std::unique_ptr<EdgePrograms> edgePrograms; // the edge pass, or the fill pass in single pass mode
+
+    // every triangle of a hexagon is baked, holes included
+    static constexpr size_t singlePassVerticesPerHexagon = 18;
+    static constexpr size_t indexedVerticesPerHexagon = 7; // the center and 6 corners
+    static constexpr size_t indicesPerHexagon = 18;
+
+    GLuint staticVAO = 0;
+    GLuint positionBuffer = 0, flagBuffer = 0;
+    GLuint staticEBO = 0; // not used in single pass mode
+    GLintptr indexOffset = 0; // of the indices in staticEBO or geometryBuffer
+    std::vector<std::uint32_t> bakeOrder;    // hexagon indices, one per slot
+    std::vector<std::uint32_t> hexagonSlots; // where each hexagon was baked, by hexagon index
+    GLuint edgeVAO = 0; // no attributes, everything is fetched from edgeTexture
+    GLuint edgeBuffer = 0, edgeTexture = 0;
+    GLsizei triangleVertexCount = 0;
+    GLsizei triangleIndexCount = 0;
+    GLsizei edgeVertexCount = 0;
+
+    // indirect path, positions first and the edge records behind them, positionBuffer, staticEBO and edgeBuffer stay 0
+    GLuint geometryBuffer = 0;
+    std::unique_ptr<modernGL::DrawCommandBuffer> drawCommands; // fillCommand and edgeCommand
+    std::unique_ptr<modernGL::ElementCommandBuffer> fillElementCommand; // replaces fillCommand outside single pass mode
+
+    static constexpr GLsizei fillCommand = 0;
+    static constexpr GLsizei edgeCommand = 1;
+
+    // GPU culling, only outside reverse mode and with compute shaders
+    GLuint cullStill = 0, cullWave = 0;
+    GLintptr edgeRecordOffset = 0;  // of the records in geometryBuffer
+    GLsizeiptr edgeRecordBytes = 0;
+    GLuint visibleBuffer = 0, visibleTexture = 0; // the records that passed, read like edgeTexture
+    std::unique_ptr<modernGL::DrawCommandBuffer> culledCommand;
+
+    // CPU culling, outside reverse mode when the GPU doesn't do it
+    std::unique_ptr<EdgeGrid> edgeGrid;
+    float gridCursorReach = 0.0f; // how far from the cursor an edge midpoint can be and still show
+    float gridWaveReach = 0.0f;   // how far from the wave center
+    EdgeGrid::Ranges visibleRanges; // in vertices
+
+    // the frame either culling last ran for, partial redraw draws it region by region
+    FrameState culledFrame{};
+    bool hasCulled = false;
+};
@@ -0,0 +1,194 @@
+#include "damageTracker.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+
+// ---------- rectangle helpers ----------
+static bool overlaps(const DamageRect& a, const DamageRect& b) {
+    return a.x <= b.x + b.width && b.x <= a.x + a.width &&
+           a.y <= b.y + b.height && b.y <= a.y + a.height;
+}
+
+static DamageRect bounds(const DamageRect& a, const DamageRect& b) {
+    int x0 = std::min(a.x, b.x);
+    int y0 = std::min(a.y, b.y);
+    int x1 = std::max(a.x + a.width, b.x + b.width);
+    int y1 = std::max(a.y + a.height, b.y + b.height);
+    return DamageRect{x0, y0, x1 - x0, y1 - y0};
+}
+
+// pixel rectangle covering [x0, x1] x [y0, y1], clipped to the screen. Empty when fully outside
+static DamageRect clippedRect(float x0, float y0, float x1, float y1, int width, int height) {
+    int ix0 = std::max(0, static_cast<int>(std::floor(x0)));
+    int iy0 = std::max(0, static_cast<int>(std::floor(y0)));
+    int ix1 = std::min(width, static_cast<int>(std::ceil(x1)));
+    int iy1 = std::min(height, static_cast<int>(std::ceil(y1)));
+    return DamageRect{ix0, iy0, std::max(0, ix1 - ix0), std::max(0, iy1 - iy0)};
+}
+
+// merges overlapping rectangles into their bounds, so no pixel is drawn twice
+static void mergeOverlapping(std::vector<DamageRect>& rects) {
+    bool merged = true;
+    while (merged) {
+        merged = false;
+        for (size_t i = 0; i < rects.size() && !merged; ++i) {
+            for (size_t j = i + 1; j < rects.size(); ++j) {
+                if (overlaps(rects[i], rects[j])) {
+                    rects[i] = bounds(rects[i], rects[j]);
+                    rects.erase(rects.begin() + j);
+                    merged = true;
+                    break;
+                }
+            }
+        }
+    }
+}
+
+
+// ---------- DamageTracker ----------
+DamageTracker::DamageTracker(const Settings& settings, const hexGrid::Layout& layout, int width, int height)
+    : width(width), height(height) {
+    EdgeReach reach = edgeReach(settings, layout);
+    cursorReach = reach.cursor;
+    waveReach = reach.wave;
+}
+
+void DamageTracker::addCursor(std::vector<DamageRect>& rects, const glm::vec2& mousePos) const {
+    DamageRect rect = clippedRect(mousePos.x - cursorReach, mousePos.y - cursorReach,
+                                  mousePos.x + cursorReach, mousePos.y + cursorReach, width, height);
+    if (rect.width > 0 && rect.height > 0) {
+        rects.push_back(rect);
+    }
+}
+
+void DamageTracker::addWave(std::vector<DamageRect>& rects, const FrameState& frame) const {
+    if (frame.waveProgress < 0.0f) {
+        return;
+    }
+
+    DamageRect rect = clippedRect(frame.waveX - waveReach, 0.0f, frame.waveX + waveReach, static_cast<float>(height), width, height);
+    if (rect.width > 0 && rect.height > 0) {
+        rects.push_back(rect);
+    }
+}
+
+bool DamageTracker::addFrame(const FrameState& frame, bool fullDamage) {
+    std::vector<DamageRect> rects;
+
+    if (fullDamage || !hasPrevious) {
+        rects.push_back(fullScreen());
+    } else {
+        if (frame.mousePos != previous.mousePos) {
+            addCursor(rects, previous.mousePos);
+            addCursor(rects, frame.mousePos);
+        }
+        if (frame.waveProgress != previous.waveProgress || frame.waveX != previous.waveX) {
+            addWave(rects, previous);
+            addWave(rects, frame);
+        }
+        mergeOverlapping(rects);
+    }
+
+    previous = frame;
+    hasPrevious = true;
+
+    // the changes were all off screen
+    if (rects.empty()) {
+        return false;
+    }
+
+    history.push_front(std::move(rects));
+    if (history.size() > maxBufferAge) {
+        history.pop_back();
+    }
+    return true;
+}
+
+std::vector<DamageRect> DamageTracker::regionsFor(int bufferAge) const {
+    if (bufferAge <= 0 || bufferAge > static_cast<int>(history.size())) {
+        return {fullScreen()};
+    }
+
+    // the buffer misses every change since the frame it holds
+    std::vector<DamageRect> rects;
+    for (int i = 0; i < bufferAge; ++i) {
+        rects.insert(rects.end(), history[i].begin(), history[i].end());
+    }
+    mergeOverlapping(rects);
+    return rects;
+}
+
+
+// ---------- RetainedFramebuffer ----------
+std::unique_ptr<RetainedFramebuffer> RetainedFramebuffer::create(int width, int height, int samples) {
+    std::unique_ptr<RetainedFramebuffer> target(new RetainedFramebuffer(width, height));
+
+    glGenRenderbuffers(1, &target->renderbuffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, target->renderbuffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+
+    glGenFramebuffers(1, &target->fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, target->fbo);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, target->renderbuffer);
+    bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+
+    if (complete && samples > 0) {
+        glGenRenderbuffers(1, &target->msRenderbuffer);
+        glBindRenderbuffer(GL_RENDERBUFFER, target->msRenderbuffer);
+        glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples, GL_RGBA8, width, height);
+
+        glGenFramebuffers(1, &target->msFBO);
+        glBindFramebuffer(GL_FRAMEBUFFER, target->msFBO);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, target->msRenderbuffer);
+        complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    }
+
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    if (!complete) {
+        std::cerr << "Failed to create retained framebuffer!" << std::endl;
+        return nullptr;
+    }
+    return target;
+}
+
+RetainedFramebuffer::~RetainedFramebuffer() {
+    glDeleteFramebuffers(1, &msFBO);
+    glDeleteRenderbuffers(1, &msRenderbuffer);
+    glDeleteFramebuffers(1, &fbo);
+    glDeleteRenderbuffers(1, &renderbuffer);
+}
+
+void RetainedFramebuffer::bind() {
+    glBindFramebuffer(GL_FRAMEBUFFER, msFBO != 0 ? msFBO : fbo);
+}
+
+// blits every region from the bound read framebuffer to the bound draw framebuffer,
+// the scissor box clips each blit
+static void blitRegions(const std::vector<DamageRect>& regions, int width, int height) {
+    glEnable(GL_SCISSOR_TEST);
+    for (const DamageRect& region : regions) {
+        glScissor(region.x, region.y, region.width, region.height);
+        glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    }
+    glDisable(GL_SCISSOR_TEST);
+}
+
+void RetainedFramebuffer::present(const std::vector<DamageRect>& regions, const std::vector<DamageRect>& windowRegions) {
+    if (msFBO != 0) {
+        // resolve only what was drawn
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, msFBO);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, fbo);
+        blitRegions(regions, width, height);
+    }
+
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, fbo);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+    blitRegions(windowRegions, width, height);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    presented = true;
+}
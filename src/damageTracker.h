@@ -0,0 +1,92 @@
+#pragma once
+
+#include <deque>
+#include <memory>
+#include <vector>
+#include <glad/glad.h>
+
+#include "settings.h"
+#include "hexGrid.h"
+#include "hexScene.h"
+
+// a window-space rectangle in GL coordinates (origin bottom left), as glScissor takes it
+struct DamageRect {
+    int x;
+    int y;
+    int width;
+    int height;
+};
+
+// Tracks which parts of the wallpaper changed from one frame to the next. Only the
+// edges react to the cursor and the wave, so a frame damages:
+//  - the barrier circles around the old and the new cursor position
+//  - the old and the new wave band, as tall as the screen
+//  - everything, when the colors changed or nothing was drawn yet
+// The last few frames are kept so a buffer of any age up to maxBufferAge can be repaired.
+class DamageTracker {
+public:
+    static constexpr int maxBufferAge = 4;
+
+    DamageTracker(const Settings& settings, const hexGrid::Layout& layout, int width, int height);
+
+    // records the damage between the previously added frame and this one. Returns false
+    // when nothing on screen changed: the frame isn't presented, so it isn't recorded and
+    // the age of every buffer stays as it is
+    bool addFrame(const FrameState& frame, bool fullDamage);
+
+    // the rectangles to repaint in a buffer that holds the frame from bufferAge frames ago.
+    // Age 0 means the contents are unknown and always gives the whole screen
+    std::vector<DamageRect> regionsFor(int bufferAge) const;
+
+private:
+    void addCursor(std::vector<DamageRect>& rects, const glm::vec2& mousePos) const;
+    void addWave(std::vector<DamageRect>& rects, const FrameState& frame) const;
+    DamageRect fullScreen() const { return DamageRect{0, 0, width, height}; }
+
+    int width;
+    int height;
+    float cursorReach; // how far from the cursor an edge pixel can change
+    float waveReach;   // how far from the wave center an edge pixel can change
+
+    bool hasPrevious = false;
+    FrameState previous{};
+    std::deque<std::vector<DamageRect>> history; // newest first
+};
+
+// An offscreen copy of the window contents that survives buffer swaps, so only the damaged
+// regions have to be drawn again. Without EGL_EXT_buffer_age the swap chain gives no
+// guarantee about what the back buffer holds and every presented frame is copied over as
+// a whole, a plain blit and far cheaper than drawing and blending the scene; with it only
+// the regions the back buffer is missing are copied.
+// Multisampled frames are resolved region by region into the copy.
+class RetainedFramebuffer {
+public:
+    static std::unique_ptr<RetainedFramebuffer> create(int width, int height, int samples);
+    ~RetainedFramebuffer();
+
+    RetainedFramebuffer(const RetainedFramebuffer&) = delete;
+    RetainedFramebuffer& operator=(const RetainedFramebuffer&) = delete;
+
+    // frames since the contents were last complete, 0 before the first present.
+    // The copy is completed by every present, unlike the window's back buffers
+    int age() const { return presented ? 1 : 0; }
+
+    // binds the framebuffer the damaged regions are drawn in
+    void bind();
+
+    // resolves the regions that were drawn, then copies windowRegions, the parts the window
+    // back buffer is missing, into it
+    void present(const std::vector<DamageRect>& regions, const std::vector<DamageRect>& windowRegions);
+
+private:
+    RetainedFramebuffer(int width, int height) : width(width), height(height) {}
+
+    int width;
+    int height;
+    bool presented = false;
+
+    GLuint renderbuffer = 0;
+    GLuint fbo = 0;
+    GLuint msRenderbuffer = 0;
+    GLuint msFBO = 0;
+};
@@ -91,3 +91,12 @@ void SetAsDesktop(HWND hwnd) {
     // Set the parent of the target window to WorkerW
     SetParent(hwnd, workerw);
 }
+
+void WatchMouseInput(HWND hwnd) {
+    RAWINPUTDEVICE mouse{};
+    mouse.usUsagePage = 0x01; // generic desktop controls
+    mouse.usUsage = 0x02;     // mouse
+    mouse.dwFlags = RIDEV_INPUTSINK;
+    mouse.hwndTarget = hwnd;
+    RegisterRawInputDevices(&mouse, 1, sizeof(mouse));
+}
@@ -6,3 +6,7 @@
 wchar_t* GetCurrentWallpaper();
 
 void SetAsDesktop(HWND hwnd);
+
+// delivers mouse movement to hwnd as WM_INPUT even though it never has focus behind
+// the desktop icons, so waiting for events wakes up when the cursor moves
+void WatchMouseInput(HWND hwnd);
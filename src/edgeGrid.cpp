@@ -0,0 +1,99 @@
+#include "edgeGrid.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+
+EdgeGrid::EdgeGrid(int width, int height, float cellSize)
+    : columns(std::max(1, static_cast<int>(std::ceil(width / cellSize)))),
+      rows(std::max(1, static_cast<int>(std::ceil(height / cellSize)))),
+      cellSize(cellSize) {
+}
+
+int EdgeGrid::cellIndex(const glm::vec2& p) const {
+    int column = std::clamp(static_cast<int>(std::floor(p.x / cellSize)), 0, columns - 1);
+    int row = std::clamp(static_cast<int>(std::floor(p.y / cellSize)), 0, rows - 1);
+    return row * columns + column;
+}
+
+std::vector<std::uint32_t> EdgeGrid::build(const std::vector<glm::vec2>& midpoints) {
+    // counting sort, the cells are known up front
+    cellStart.assign(static_cast<size_t>(columns) * rows + 1, 0);
+    for (const glm::vec2& midpoint : midpoints) {
+        cellStart[cellIndex(midpoint) + 1]++;
+    }
+    for (size_t i = 1; i < cellStart.size(); i++) {
+        cellStart[i] += cellStart[i - 1];
+    }
+
+    std::vector<std::uint32_t> next(cellStart.begin(), cellStart.end() - 1);
+    std::vector<std::uint32_t> order(midpoints.size());
+    for (size_t i = 0; i < midpoints.size(); i++) {
+        order[next[cellIndex(midpoints[i])]++] = static_cast<std::uint32_t>(i);
+    }
+    return order;
+}
+
+void EdgeGrid::columnSpan(float x0, float x1, int& first, int& last) const {
+    first = std::clamp(static_cast<int>(std::floor(x0 / cellSize)), 0, columns - 1);
+    last = std::clamp(static_cast<int>(std::floor(x1 / cellSize)), 0, columns - 1);
+}
+
+void EdgeGrid::addRun(int row, int firstColumn, int lastColumn, Ranges& out) const {
+    GLint first = static_cast<GLint>(cellStart[row * columns + firstColumn]);
+    GLsizei count = static_cast<GLsizei>(cellStart[row * columns + lastColumn + 1]) - first;
+    if (count <= 0) {
+        return;
+    }
+
+    // the end of one row and the start of the next are neighbours in the buffer too
+    if (!out.firsts.empty() && out.firsts.back() + out.counts.back() == first) {
+        out.counts.back() += count;
+    } else {
+        out.firsts.push_back(first);
+        out.counts.push_back(count);
+    }
+}
+
+void EdgeGrid::query(const glm::vec2& point, float reach, bool band, float bandX, float bandHalfWidth, Ranges& out) const {
+    out.firsts.clear();
+    out.counts.clear();
+    if (cellStart.empty()) {
+        return;
+    }
+
+    int bandFirst = 0, bandLast = -1;
+    if (band) {
+        columnSpan(bandX - bandHalfWidth, bandX + bandHalfWidth, bandFirst, bandLast);
+    }
+
+    const float infinity = std::numeric_limits<float>::infinity();
+    for (int row = 0; row < rows; row++) {
+        // the border rows hold everything beyond them as well
+        float y0 = row == 0 ? -infinity : row * cellSize;
+        float y1 = row == rows - 1 ? infinity : (row + 1) * cellSize;
+        float dy = point.y < y0 ? y0 - point.y : (point.y > y1 ? point.y - y1 : 0.0f);
+
+        int circleFirst = 0, circleLast = -1;
+        if (dy < reach) {
+            float dx = std::sqrt(reach * reach - dy * dy);
+            columnSpan(point.x - dx, point.x + dx, circleFirst, circleLast);
+        }
+
+        bool hasCircle = circleFirst <= circleLast;
+        bool hasBand = bandFirst <= bandLast;
+        if (hasCircle && hasBand && circleFirst <= bandLast + 1 && bandFirst <= circleLast + 1) {
+            addRun(row, std::min(circleFirst, bandFirst), std::max(circleLast, bandLast), out);
+        } else if (hasCircle && hasBand) {
+            // ranges have to be in buffer order to merge across rows
+            bool circleFirstInRow = circleFirst < bandFirst;
+            addRun(row, circleFirstInRow ? circleFirst : bandFirst, circleFirstInRow ? circleLast : bandLast, out);
+            addRun(row, circleFirstInRow ? bandFirst : circleFirst, circleFirstInRow ? bandLast : circleLast, out);
+        } else if (hasCircle) {
+            addRun(row, circleFirst, circleLast, out);
+        } else if (hasBand) {
+            addRun(row, bandFirst, bandLast, out);
+        }
+    }
+}
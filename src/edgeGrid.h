@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+// A uniform grid of square cells over the screen. Records are sorted by the cell of
+// their midpoint, so every cell owns one contiguous range of the buffer and any set of
+// neighbouring cells in a row is a single run, which a multi-draw can draw in one go.
+// Midpoints off screen belong to the nearest border cell.
+class EdgeGrid {
+public:
+    EdgeGrid(int width, int height, float cellSize);
+
+    // sorts the records by cell, in row-major cell order and stable within a cell. Returns
+    // for every slot of the sorted buffer the index of the record that goes there
+    std::vector<std::uint32_t> build(const std::vector<glm::vec2>& midpoints);
+
+    // record ranges, as glMultiDrawArrays takes them
+    struct Ranges {
+        std::vector<GLint> firsts;
+        std::vector<GLsizei> counts;
+    };
+
+    // The records whose midpoint may be closer than reach to point, plus, when band is
+    // set, those whose midpoint x is closer than bandHalfWidth to bandX. Whole cells are
+    // returned, so the result holds every such record and a few more around them
+    void query(const glm::vec2& point, float reach, bool band, float bandX, float bandHalfWidth, Ranges& out) const;
+
+private:
+    int cellIndex(const glm::vec2& p) const;
+    // column span of [x0, x1], clamped to the grid
+    void columnSpan(float x0, float x1, int& first, int& last) const;
+    void addRun(int row, int firstColumn, int lastColumn, Ranges& out) const;
+
+    int columns;
+    int rows;
+    float cellSize;
+    std::vector<std::uint32_t> cellStart; // first record of every cell, and the record count at the end
+};
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <string_view>
+
+// a shader source compiled into the executable
+struct EmbeddedShader {
+    std::string_view name;   // path relative to the shaders directory, "/" separated
+    std::string_view source;
+};
+
+// every file of the shaders directory, generated at build time by cmake/EmbedShaders.cmake
+std::span<const EmbeddedShader> embeddedShaders();
+
+// a shader compiled to SPIR-V for the Vulkan backend, in one combination of features
+struct EmbeddedSpirv {
+    std::string_view name;   // the source it was compiled from
+    std::uint32_t features;  // shaderUtils::Feature bits it was compiled with
+    std::span<const std::uint32_t> code;
+};
+
+// every Vulkan shader variant, empty when the build has no Vulkan backend
+std::span<const EmbeddedSpirv> embeddedSpirv();
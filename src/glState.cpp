@@ -0,0 +1,73 @@
+#include "glState.h"
+
+// never a valid name or enum, so nothing matches before the first call
+static constexpr GLuint unknown = 0xFFFFFFFFu;
+
+namespace {
+    struct State {
+        GLuint program = unknown;
+        GLuint vertexArray = unknown;
+        GLenum blendSourceRGB = unknown;
+        GLenum blendDestinationRGB = unknown;
+        GLenum blendSourceAlpha = unknown;
+        GLenum blendDestinationAlpha = unknown;
+        GLenum blendEquation = unknown;
+    };
+
+    // every thread has its own context current, and with it its own bindings
+    thread_local State state;
+}
+
+void glState::useProgram(GLuint program) {
+    if (state.program != program) {
+        glUseProgram(program);
+        state.program = program;
+    }
+}
+
+void glState::bindVertexArray(GLuint vertexArray) {
+    if (state.vertexArray != vertexArray) {
+        glBindVertexArray(vertexArray);
+        state.vertexArray = vertexArray;
+    }
+}
+
+void glState::blendFunc(GLenum source, GLenum destination) {
+    blendFuncSeparate(source, destination, source, destination);
+}
+
+void glState::blendFuncSeparate(GLenum sourceRGB, GLenum destinationRGB, GLenum sourceAlpha, GLenum destinationAlpha) {
+    if (state.blendSourceRGB != sourceRGB || state.blendDestinationRGB != destinationRGB ||
+        state.blendSourceAlpha != sourceAlpha || state.blendDestinationAlpha != destinationAlpha) {
+        glBlendFuncSeparate(sourceRGB, destinationRGB, sourceAlpha, destinationAlpha);
+        state.blendSourceRGB = sourceRGB;
+        state.blendDestinationRGB = destinationRGB;
+        state.blendSourceAlpha = sourceAlpha;
+        state.blendDestinationAlpha = destinationAlpha;
+    }
+}
+
+void glState::blendEquation(GLenum mode) {
+    if (state.blendEquation != mode) {
+        glBlendEquation(mode);
+        state.blendEquation = mode;
+    }
+}
+
+void glState::deleteProgram(GLuint program) {
+    glDeleteProgram(program);
+    if (state.program == program) {
+        state.program = unknown;
+    }
+}
+
+void glState::deleteVertexArray(GLuint vertexArray) {
+    glDeleteVertexArrays(1, &vertexArray);
+    if (state.vertexArray == vertexArray) {
+        state.vertexArray = unknown;
+    }
+}
+
+void glState::invalidate() {
+    state = State{};
+}
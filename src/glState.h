@@ -0,0 +1,23 @@
+#pragma once
+
+#include <glad/glad.h>
+
+// Remembers the GL state that changes between draws and skips the calls that wouldn't
+// change anything, which saves driver work on every frame. The cache only holds while all
+// changes to these states go through here: programs, vertex arrays and blending.
+// Every thread keeps its own cache, for the context it has current.
+namespace glState {
+    void useProgram(GLuint program);
+    void bindVertexArray(GLuint vertexArray);
+
+    void blendFunc(GLenum source, GLenum destination);
+    void blendFuncSeparate(GLenum sourceRGB, GLenum destinationRGB, GLenum sourceAlpha, GLenum destinationAlpha);
+    void blendEquation(GLenum mode);
+
+    // delete the object, and forget it when it is bound so a new object reusing the name gets bound
+    void deleteProgram(GLuint program);
+    void deleteVertexArray(GLuint vertexArray);
+
+    // forgets everything, the next call of each kind goes to GL again
+    void invalidate();
+}
@@ -0,0 +1,114 @@
+#include "gles.h"
+
+#include <cstring>
+#include <iostream>
+
+
+// the EGL part used here, every ES context is created through EGL
+typedef void* EGLDisplay;
+typedef void* EGLSurface;
+typedef khronos_int32_t EGLint;
+typedef unsigned int EGLBoolean;
+#define EGL_EXTENSIONS     0x3055
+#define EGL_DRAW           0x3059
+#define EGL_BUFFER_AGE_EXT 0x313D
+
+typedef EGLDisplay (KHRONOS_APIENTRY *PFNEGLGETCURRENTDISPLAYPROC)(void);
+typedef EGLSurface (KHRONOS_APIENTRY *PFNEGLGETCURRENTSURFACEPROC)(EGLint readdraw);
+typedef const char* (KHRONOS_APIENTRY *PFNEGLQUERYSTRINGPROC)(EGLDisplay dpy, EGLint name);
+typedef EGLBoolean (KHRONOS_APIENTRY *PFNEGLQUERYSURFACEPROC)(EGLDisplay dpy, EGLSurface surface, EGLint attribute, EGLint* value);
+
+static bool esContext = false;
+
+static PFNEGLGETCURRENTDISPLAYPROC eglGetCurrentDisplay = nullptr;
+static PFNEGLGETCURRENTSURFACEPROC eglGetCurrentSurface = nullptr;
+static PFNEGLQUERYSURFACEPROC eglQuerySurface = nullptr;
+static bool bufferAgeAvailable = false;
+
+bool gles::hasExtension(const char* extensions, const char* name) {
+    size_t length = std::strlen(name);
+    for (const char* at = extensions; at && (at = std::strstr(at, name)) != nullptr; at += length) {
+        if ((at == extensions || at[-1] == ' ') && (at[length] == ' ' || at[length] == '\0')) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool gles::load(GLADloadproc load) {
+    const char* version = reinterpret_cast<const char*>(glGetString(GL_VERSION));
+    if (!version || std::strncmp(version, "OpenGL ES ", 10) != 0) {
+        return false;
+    }
+    if (GLVersion.major < 3) {
+        std::cerr << "OpenGL ES 3.0 is required, the context is " << version << std::endl;
+        return false;
+    }
+
+    // desktop GL 3.1
+    glad_glDrawArraysInstanced = reinterpret_cast<PFNGLDRAWARRAYSINSTANCEDPROC>(load("glDrawArraysInstanced"));
+    glad_glDrawElementsInstanced = reinterpret_cast<PFNGLDRAWELEMENTSINSTANCEDPROC>(load("glDrawElementsInstanced"));
+    glad_glCopyBufferSubData = reinterpret_cast<PFNGLCOPYBUFFERSUBDATAPROC>(load("glCopyBufferSubData"));
+    glad_glGetUniformIndices = reinterpret_cast<PFNGLGETUNIFORMINDICESPROC>(load("glGetUniformIndices"));
+    glad_glGetActiveUniformsiv = reinterpret_cast<PFNGLGETACTIVEUNIFORMSIVPROC>(load("glGetActiveUniformsiv"));
+    glad_glGetUniformBlockIndex = reinterpret_cast<PFNGLGETUNIFORMBLOCKINDEXPROC>(load("glGetUniformBlockIndex"));
+    glad_glGetActiveUniformBlockiv = reinterpret_cast<PFNGLGETACTIVEUNIFORMBLOCKIVPROC>(load("glGetActiveUniformBlockiv"));
+    glad_glGetActiveUniformBlockName = reinterpret_cast<PFNGLGETACTIVEUNIFORMBLOCKNAMEPROC>(load("glGetActiveUniformBlockName"));
+    glad_glUniformBlockBinding = reinterpret_cast<PFNGLUNIFORMBLOCKBINDINGPROC>(load("glUniformBlockBinding"));
+    glad_glBindBufferRange = reinterpret_cast<PFNGLBINDBUFFERRANGEPROC>(load("glBindBufferRange"));
+    glad_glBindBufferBase = reinterpret_cast<PFNGLBINDBUFFERBASEPROC>(load("glBindBufferBase"));
+    glad_glGetIntegeri_v = reinterpret_cast<PFNGLGETINTEGERI_VPROC>(load("glGetIntegeri_v"));
+
+    // desktop GL 3.2
+    glad_glFenceSync = reinterpret_cast<PFNGLFENCESYNCPROC>(load("glFenceSync"));
+    glad_glIsSync = reinterpret_cast<PFNGLISSYNCPROC>(load("glIsSync"));
+    glad_glDeleteSync = reinterpret_cast<PFNGLDELETESYNCPROC>(load("glDeleteSync"));
+    glad_glClientWaitSync = reinterpret_cast<PFNGLCLIENTWAITSYNCPROC>(load("glClientWaitSync"));
+    glad_glWaitSync = reinterpret_cast<PFNGLWAITSYNCPROC>(load("glWaitSync"));
+    glad_glGetInteger64v = reinterpret_cast<PFNGLGETINTEGER64VPROC>(load("glGetInteger64v"));
+    glad_glGetSynciv = reinterpret_cast<PFNGLGETSYNCIVPROC>(load("glGetSynciv"));
+
+    // desktop GL 3.3
+    glad_glVertexAttribDivisor = reinterpret_cast<PFNGLVERTEXATTRIBDIVISORPROC>(load("glVertexAttribDivisor"));
+
+    esContext = glad_glGetUniformBlockIndex && glad_glUniformBlockBinding && glad_glBindBufferRange &&
+                glad_glFenceSync && glad_glClientWaitSync && glad_glDeleteSync && glad_glDrawArraysInstanced &&
+                glad_glVertexAttribDivisor;
+    if (!esContext) {
+        std::cerr << "Failed to load the OpenGL ES 3.0 functions" << std::endl;
+        return false;
+    }
+
+    // EGL 1.5 hands out its core functions through the same lookup
+    eglGetCurrentDisplay = reinterpret_cast<PFNEGLGETCURRENTDISPLAYPROC>(load("eglGetCurrentDisplay"));
+    eglGetCurrentSurface = reinterpret_cast<PFNEGLGETCURRENTSURFACEPROC>(load("eglGetCurrentSurface"));
+    eglQuerySurface = reinterpret_cast<PFNEGLQUERYSURFACEPROC>(load("eglQuerySurface"));
+    auto eglQueryString = reinterpret_cast<PFNEGLQUERYSTRINGPROC>(load("eglQueryString"));
+    if (eglGetCurrentDisplay && eglGetCurrentSurface && eglQuerySurface && eglQueryString) {
+        bufferAgeAvailable = hasExtension(eglQueryString(eglGetCurrentDisplay(), EGL_EXTENSIONS), "EGL_EXT_buffer_age");
+    }
+    return true;
+}
+
+bool gles::active() {
+    return esContext;
+}
+
+void gles::adaptSettings(Settings& settings) {
+    // the outline pass reads a buffer texture, which ES only has from 3.2
+    if (esContext && settings.renderMode == RenderMode::Baked && !settings.singlePass) {
+        std::cerr << "Buffer textures unavailable on OpenGL ES, drawing the outlines in the fill pass" << std::endl;
+        settings.singlePass = true;
+    }
+}
+
+int gles::bufferAge() {
+    if (!bufferAgeAvailable) {
+        return 0;
+    }
+    EGLint age = 0;
+    if (!eglQuerySurface(eglGetCurrentDisplay(), eglGetCurrentSurface(EGL_DRAW), EGL_BUFFER_AGE_EXT, &age)) {
+        return 0;
+    }
+    return age;
+}
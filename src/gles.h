@@ -0,0 +1,28 @@
+#pragma once
+
+#include <glad/glad.h>
+
+#include "settings.h"
+
+// OpenGL ES 3.0 contexts, for devices without desktop GL. They draw into the same window
+// as desktop GL, or offscreen without one through a HeadlessContext. glad only knows desktop
+// versions and reads "OpenGL ES 3.0" as GL 3.0, which leaves out the parts of ES 3.0
+// that came with desktop GL 3.1 to 3.3: uniform blocks, sync objects, instancing.
+// The same entry points exist under the same names on ES, load() fills them in.
+// Shaders are rewritten to GLSL ES 3.00 while active, see shaderUtils::compileShaders.
+namespace gles {
+    // call right after glad is loaded. Returns false and changes nothing on desktop GL
+    bool load(GLADloadproc load);
+    // the current context is OpenGL ES
+    bool active();
+
+    // turns off what settings asks for and ES 3.0 can't do, saying so. Call after load()
+    void adaptSettings(Settings& settings);
+
+    // name is one of the space separated extensions
+    bool hasExtension(const char* extensions, const char* name);
+
+    // frames since the window back buffer was last drawn, from EGL_EXT_buffer_age.
+    // 0 when its contents are unknown, which is always the case without the extension
+    int bufferAge();
+}
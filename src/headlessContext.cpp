@@ -0,0 +1,111 @@
+#include "headlessContext.h"
+#include "gles.h"
+#include "glState.h"
+
+#include <EGL/eglext.h>
+#include <iostream>
+
+
+std::unique_ptr<HeadlessContext> HeadlessContext::create(bool withPbuffer) {
+    std::unique_ptr<HeadlessContext> headless(new HeadlessContext());
+
+    // ---------- Mesa's surfaceless platform, no display server at all ----------
+    bool created = false;
+    const char* clientExtensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+    auto getPlatformDisplay = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+    if (getPlatformDisplay && gles::hasExtension(clientExtensions, "EGL_MESA_platform_surfaceless")) {
+        created = headless->createOn(getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr), withPbuffer);
+    }
+
+    // ---------- otherwise the driver's default display ----------
+    if (!created) {
+        created = headless->createOn(eglGetDisplay(EGL_DEFAULT_DISPLAY), withPbuffer);
+    }
+    if (!created) {
+        std::cerr << "Failed to create a headless OpenGL ES 3.0 context" << std::endl;
+        return nullptr;
+    }
+
+    if (!gladLoadGLLoader(reinterpret_cast<GLADloadproc>(eglGetProcAddress)) ||
+        !gles::load(reinterpret_cast<GLADloadproc>(eglGetProcAddress))) {
+        std::cerr << "Failed to initialize OpenGL ES 3.0" << std::endl;
+        return nullptr;
+    }
+    // a new context, nothing cached for an earlier one holds
+    glState::invalidate();
+    return headless;
+}
+
+bool HeadlessContext::createOn(EGLDisplay candidate, bool withPbuffer) {
+    if (candidate == EGL_NO_DISPLAY || !eglInitialize(candidate, nullptr, nullptr)) {
+        return false;
+    }
+
+    EGLContext created = EGL_NO_CONTEXT;
+    EGLSurface pbuffer = EGL_NO_SURFACE;
+    auto fail = [&]() {
+        if (pbuffer != EGL_NO_SURFACE) {
+            eglDestroySurface(candidate, pbuffer);
+        }
+        if (created != EGL_NO_CONTEXT) {
+            eglDestroyContext(candidate, created);
+        }
+        eglTerminate(candidate);
+        return false;
+    };
+
+    if (!eglBindAPI(EGL_OPENGL_ES_API)) {
+        return fail();
+    }
+
+    const bool surfaceless = !withPbuffer && gles::hasExtension(eglQueryString(candidate, EGL_EXTENSIONS), "EGL_KHR_surfaceless_context");
+    const EGLint configAttributes[] = {
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_ES3_BIT,
+        EGL_SURFACE_TYPE, surfaceless ? 0 : EGL_PBUFFER_BIT,
+        EGL_RED_SIZE, 8,
+        EGL_GREEN_SIZE, 8,
+        EGL_BLUE_SIZE, 8,
+        EGL_NONE
+    };
+    EGLConfig config = nullptr;
+    EGLint configCount = 0;
+    if (!eglChooseConfig(candidate, configAttributes, &config, 1, &configCount) || configCount == 0) {
+        return fail();
+    }
+
+    const EGLint contextAttributes[] = { EGL_CONTEXT_CLIENT_VERSION, 3, EGL_NONE };
+    created = eglCreateContext(candidate, config, EGL_NO_CONTEXT, contextAttributes);
+    if (created == EGL_NO_CONTEXT) {
+        return fail();
+    }
+
+    // the pbuffer is never drawn to, it only exists to make the context current
+    if (!surfaceless) {
+        const EGLint pbufferAttributes[] = { EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE };
+        pbuffer = eglCreatePbufferSurface(candidate, config, pbufferAttributes);
+        if (pbuffer == EGL_NO_SURFACE) {
+            return fail();
+        }
+    }
+
+    if (!eglMakeCurrent(candidate, pbuffer, pbuffer, created)) {
+        return fail();
+    }
+
+    display = candidate;
+    surface = pbuffer;
+    context = created;
+    return true;
+}
+
+HeadlessContext::~HeadlessContext() {
+    if (display == EGL_NO_DISPLAY) {
+        return;
+    }
+    eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    if (surface != EGL_NO_SURFACE) {
+        eglDestroySurface(display, surface);
+    }
+    eglDestroyContext(display, context);
+    eglTerminate(display);
+}
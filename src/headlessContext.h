@@ -0,0 +1,35 @@
+#pragma once
+
+#include <memory>
+#include <EGL/egl.h>
+
+// An OpenGL ES 3.0 context without a window, for machines with no display server such as
+// kiosk images and build servers. EGL's surfaceless platform (Mesa) is tried first, it
+// needs no surface at all; otherwise a 1x1 pbuffer keeps the context current on the
+// default display. Neither has a framebuffer worth drawing into, everything is drawn
+// into framebuffer objects.
+class HeadlessContext {
+public:
+    // creates the context and makes it current on the calling thread, with glad and
+    // gles::load() done. withPbuffer uses a pbuffer even where none is needed.
+    // Returns nullptr when EGL offers neither
+    static std::unique_ptr<HeadlessContext> create(bool withPbuffer = false);
+    ~HeadlessContext();
+
+    HeadlessContext(const HeadlessContext&) = delete;
+    HeadlessContext& operator=(const HeadlessContext&) = delete;
+
+    // no pbuffer was needed
+    bool surfaceless() const { return surface == EGL_NO_SURFACE; }
+
+private:
+    HeadlessContext() = default;
+
+    // makes an ES 3 context current on display, without a surface when it can and
+    // withPbuffer is off. False leaves nothing behind
+    bool createOn(EGLDisplay display, bool withPbuffer);
+
+    EGLDisplay display = EGL_NO_DISPLAY;
+    EGLSurface surface = EGL_NO_SURFACE;
+    EGLContext context = EGL_NO_CONTEXT;
+};
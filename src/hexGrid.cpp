@@ -0,0 +1,162 @@
+#include "hexGrid.h"
+
+#include <algorithm>
+#include <cmath>
+#include <unordered_set>
+
+// Edges are deduplicated on their endpoints snapped to 1/64 of a pixel, so the
+// float noise of neighbouring hexagons computing the same corner doesn't matter.
+static constexpr float edgeKeyScale = 64.0f;
+
+struct EdgeKey {
+    std::int32_t ax, ay, bx, by;
+
+    bool operator==(const EdgeKey&) const = default;
+};
+
+struct EdgeKeyHash {
+    size_t operator()(const EdgeKey& key) const {
+        std::uint64_t a = (static_cast<std::uint64_t>(static_cast<std::uint32_t>(key.ax)) << 32) | static_cast<std::uint32_t>(key.ay);
+        std::uint64_t b = (static_cast<std::uint64_t>(static_cast<std::uint32_t>(key.bx)) << 32) | static_cast<std::uint32_t>(key.by);
+        return std::hash<std::uint64_t>{}(a ^ (b * 0x9E3779B97F4A7C15ull));
+    }
+};
+
+// direction independent key of the segment p1-p2
+static EdgeKey makeEdgeKey(const glm::vec2& p1, const glm::vec2& p2) {
+    std::int32_t ax = static_cast<std::int32_t>(std::lround(p1.x * edgeKeyScale));
+    std::int32_t ay = static_cast<std::int32_t>(std::lround(p1.y * edgeKeyScale));
+    std::int32_t bx = static_cast<std::int32_t>(std::lround(p2.x * edgeKeyScale));
+    std::int32_t by = static_cast<std::int32_t>(std::lround(p2.y * edgeKeyScale));
+    if (ax > bx || (ax == bx && ay > by)) {
+        return { bx, by, ax, ay };
+    }
+    return { ax, ay, bx, by };
+}
+
+// spokes are never shared, a border belongs to the first hexagon that claims it
+static void assignBorders(std::vector<hexGrid::Hexagon>& hexagons, const hexGrid::Layout& layout) {
+    std::unordered_set<EdgeKey, EdgeKeyHash> claimed;
+    claimed.reserve(hexagons.size() * 3);
+
+    for (hexGrid::Hexagon& hexagon : hexagons) {
+        hexagon.borderMask = 0;
+        for (int k = 0; k < hexGrid::borderCount; k++) {
+            glm::vec2 p1 = hexagon.center + layout.corners[k];
+            glm::vec2 p2 = hexagon.center + layout.corners[(k + 1) % hexGrid::CornerCount];
+            if (claimed.insert(makeEdgeKey(p1, p2)).second) {
+                hexagon.borderMask |= 1u << k;
+            }
+        }
+    }
+}
+
+// distance of cell (x, y) along the Hilbert curve filling a side x side square, side a power of two
+static std::uint64_t hilbertIndex(std::uint32_t side, std::uint32_t x, std::uint32_t y) {
+    std::uint64_t index = 0;
+    for (std::uint32_t s = side / 2; s > 0; s /= 2) {
+        std::uint32_t rx = (x & s) ? 1 : 0;
+        std::uint32_t ry = (y & s) ? 1 : 0;
+        index += static_cast<std::uint64_t>(s) * s * ((3 * rx) ^ ry);
+
+        // rotate the quadrant so the curve enters and leaves it where the next one expects
+        if (ry == 0) {
+            if (rx == 1) {
+                x = side - 1 - x;
+                y = side - 1 - y;
+            }
+            std::swap(x, y);
+        }
+    }
+    return index;
+}
+
+
+hexGrid::Layout hexGrid::makeLayout(float hexagonSize, float screenWidth, float screenHeight) {
+    Layout layout;
+    layout.size = hexagonSize;
+    layout.width = 1.7320508075688772f * hexagonSize;
+    layout.sliceWidth = 0.8660254037844386f * hexagonSize;
+    layout.halfSize = 0.5f * hexagonSize;
+    layout.yDistance = 1.5f * hexagonSize;
+    layout.rows = static_cast<int>(screenHeight / layout.yDistance) + 1;
+    layout.screenWidth = screenWidth;
+    layout.screenHeight = screenHeight;
+
+    layout.corners[Top]         = glm::vec2(0.0f, hexagonSize);
+    layout.corners[RightTop]    = glm::vec2(layout.sliceWidth, layout.halfSize);
+    layout.corners[RightBottom] = glm::vec2(layout.sliceWidth, -layout.halfSize);
+    layout.corners[Bottom]      = glm::vec2(0.0f, -hexagonSize);
+    layout.corners[LeftBottom]  = glm::vec2(-layout.sliceWidth, -layout.halfSize);
+    layout.corners[LeftTop]     = glm::vec2(-layout.sliceWidth, layout.halfSize);
+
+    return layout;
+}
+
+std::vector<hexGrid::Hexagon> hexGrid::generate(const Layout& layout, std::mt19937& rng) {
+    std::uniform_real_distribution<> dist(0.0f, 1.0f);
+    const int hexagonsInWidth = static_cast<int>(layout.screenWidth / layout.width) + 2;
+
+    std::vector<Hexagon> hexagons;
+    hexagons.reserve(static_cast<size_t>(layout.rows + 1) * hexagonsInWidth);
+
+    for (int iy = 0; iy <= layout.rows; iy++) {
+        float y = iy * layout.yDistance;
+        for (float x = (iy % 2 ? 0.0f : layout.sliceWidth); x <= layout.screenWidth + layout.width; x += layout.width) {
+            Hexagon hexagon{ glm::vec2(x, y), 0, 0 };
+
+            for (size_t i = 0; i < triangles.size(); i++) {
+                const Triangle& triangle = triangles[i];
+                glm::vec2 a = hexagon.center + layout.corners[triangle.a];
+                glm::vec2 b = hexagon.center + layout.corners[triangle.b];
+
+                // the higher the triangle, the more likely it is left out
+                float triangleY = (hexagon.center.y + a.y + b.y) / 3.0f;
+                float normalizedY = triangleY / layout.screenHeight;
+                float probability = pow(normalizedY, 2.0f);
+                if (static_cast<float>(dist(rng)) >= probability) {
+                    hexagon.fillMask |= 1u << i;
+                }
+            }
+
+            hexagons.push_back(hexagon);
+        }
+    }
+
+    assignBorders(hexagons, layout);
+
+    return hexagons;
+}
+
+std::vector<std::uint32_t> hexGrid::curveOrder(const Layout& layout, const std::vector<Hexagon>& hexagons) {
+    // the column of a hexagon, with the half-width offset of every other row rounded away
+    auto column = [&](const Hexagon& hexagon) {
+        return static_cast<std::uint32_t>(std::max(0L, std::lround(hexagon.center.x / layout.width - 0.25f)));
+    };
+    auto row = [&](const Hexagon& hexagon) {
+        return static_cast<std::uint32_t>(std::max(0L, std::lround(hexagon.center.y / layout.yDistance)));
+    };
+
+    std::uint32_t extent = 1;
+    for (const Hexagon& hexagon : hexagons) {
+        extent = std::max({ extent, column(hexagon) + 1, row(hexagon) + 1 });
+    }
+    std::uint32_t side = 1;
+    while (side < extent) {
+        side *= 2;
+    }
+
+    std::vector<std::pair<std::uint64_t, std::uint32_t>> keyed;
+    keyed.reserve(hexagons.size());
+    for (size_t i = 0; i < hexagons.size(); i++) {
+        keyed.emplace_back(hilbertIndex(side, column(hexagons[i]), row(hexagons[i])), static_cast<std::uint32_t>(i));
+    }
+    std::sort(keyed.begin(), keyed.end());
+
+    std::vector<std::uint32_t> order;
+    order.reserve(keyed.size());
+    for (const auto& [key, index] : keyed) {
+        order.push_back(index);
+    }
+    return order;
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <random>
+#include <vector>
+#include <glm/glm.hpp>
+
+// Layout of the hexagon tessellation and the one-time fill randomization.
+// Every render mode builds its geometry from the hexagons generated here.
+namespace hexGrid {
+    // hexagon corners, clockwise starting from the top
+    enum Corner { Top, RightTop, RightBottom, Bottom, LeftBottom, LeftTop, CornerCount };
+
+    // cube faces, used as an index into the cube colors
+    enum Face { FaceTop, FaceLeft, FaceRight, FaceCount };
+
+    // a triangle of the hexagon: the center plus two corners
+    struct Triangle {
+        Corner a;
+        Corner b;
+        Face face;
+    };
+
+    // the 6 triangles of a hexagon, in the order they have always been emitted
+    inline constexpr std::array<Triangle, 6> triangles{{
+        { Top,    LeftTop,     FaceTop   },
+        { Top,    RightTop,    FaceTop   },
+        { LeftTop, LeftBottom, FaceLeft  },
+        { RightTop, RightBottom, FaceRight },
+        { Bottom, LeftBottom,  FaceLeft  },
+        { Bottom, RightBottom, FaceRight },
+    }};
+
+    // border k runs from corner k to corner k + 1, spoke k from the center to corner k
+    inline constexpr int borderCount = CornerCount;
+    inline constexpr int spokeCount = CornerCount;
+
+    struct Layout {
+        float size;           // center to corner
+        float width;          // distance between two centers of a row
+        float sliceWidth;     // half of width, x offset of the even rows
+        float halfSize;
+        float yDistance;      // distance between two rows
+        int rows;             // rows are numbered 0..rows (inclusive)
+        float screenWidth;
+        float screenHeight;
+        std::array<glm::vec2, CornerCount> corners; // corner offsets from the center
+    };
+
+    struct Hexagon {
+        glm::vec2 center;
+        std::uint32_t fillMask;   // bit i is set when triangles[i] is filled, cleared for holes
+        std::uint32_t borderMask; // bit k is set when this hexagon draws border k, every border is owned by one hexagon
+    };
+
+    Layout makeLayout(float hexagonSize, float screenWidth, float screenHeight);
+
+    // walks the grid in scanline order, rolls the fill/hole dice for every triangle
+    // and hands every shared border to exactly one of its hexagons
+    std::vector<Hexagon> generate(const Layout& layout, std::mt19937& rng);
+
+    // indices into hexagons along a Hilbert curve through the grid, so that hexagons
+    // close in the list are close on screen as well
+    std::vector<std::uint32_t> curveOrder(const Layout& layout, const std::vector<Hexagon>& hexagons);
+}
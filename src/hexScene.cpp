@@ -0,0 +1,120 @@
+#include "hexScene.h"
+#include "bakedScene.h"
+#include "instancedScene.h"
+#include "proceduralScene.h"
+#include "glState.h"
+
+#include <iostream>
+
+
+void bindFrameBlock(GLuint program) {
+    GLuint blockIndex = glGetUniformBlockIndex(program, "Frame");
+    if (blockIndex != GL_INVALID_INDEX) {
+        glUniformBlockBinding(program, blockIndex, frameBindingPoint);
+    }
+}
+
+float fillExpansion(const Settings& settings) {
+    return settings.MSAA > 0 ? 0.0f : 0.5f;
+}
+
+EdgeReach edgeReach(const Settings& settings, const hexGrid::Layout& layout) {
+    float edgeMargin = settings.edges.width * 0.5f + 2.0f;
+
+    // edges fade in or out up to the barrier radius, and up to the fade area behind it in reverse mode
+    float barrierReach = settings.barrier.radius + (settings.barrier.reverse ? settings.barrier.fadeArea : 0.0f);
+    return EdgeReach{ barrierReach + layout.size + edgeMargin, settings.wave.width * 0.5f + layout.size * 0.5f + edgeMargin };
+}
+
+FrameBlock makeFrameBlock(const Settings& settings, const FrameState& frame) {
+    FrameBlock block{};
+    block.halfWidth = frame.halfWidth;
+    block.halfHeight = frame.halfHeight;
+    block.mousePos = frame.mousePos;
+    block.barrierRadius = settings.barrier.radius;
+    block.fadeArea = settings.barrier.fadeArea;
+    block.edgeWidth = settings.edges.width;
+
+    // only the wave variants read these
+    block.waveX = frame.waveX;
+    block.waveColor = glm::vec4(settings.wave.color[0], settings.wave.color[1], settings.wave.color[2], settings.wave.color[3]);
+    block.waveWidth = settings.wave.width;
+    return block;
+}
+
+FrameUniformBuffer::FrameUniformBuffer(const Settings& settings)
+    : settings(settings), stream(StreamBuffer::create(GL_UNIFORM_BUFFER, sizeof(FrameBlock))) {}
+
+FrameUniformBuffer::~FrameUniformBuffer() = default;
+
+void FrameUniformBuffer::update(const FrameState& frame) {
+    if (hasUploaded && frame == uploaded) {
+        return;
+    }
+
+    FrameBlock block = makeFrameBlock(settings, frame);
+
+    // a region of its own for every upload, frames still in flight keep reading theirs
+    stream->beginFrame();
+    StreamBuffer::Allocation allocation = stream->write(&block, sizeof(FrameBlock));
+    glBindBufferRange(GL_UNIFORM_BUFFER, frameBindingPoint, allocation.buffer, allocation.offset, allocation.size);
+
+    uploaded = frame;
+    hasUploaded = true;
+}
+
+std::unique_ptr<EdgePrograms> EdgePrograms::create(const Settings& settings, const std::string& vertexPath,
+                                                   const std::string& fragmentPath, bool analyticAA) {
+    std::unique_ptr<EdgePrograms> programs(new EdgePrograms(vertexPath, fragmentPath));
+
+    std::uint32_t features = 0;
+    if (settings.barrier.reverse) features |= shaderUtils::FeatureReverse;
+    if (analyticAA) features |= shaderUtils::FeatureAnalyticAA;
+
+    programs->still = programs->variants.get(features);
+    programs->wave = programs->variants.get(features | shaderUtils::FeatureWave);
+    if (programs->still == 0 || programs->wave == 0) {
+        std::cerr << "Failed to compile edge program variants of " << fragmentPath << "!" << std::endl;
+        return nullptr;
+    }
+    return programs;
+}
+
+void EdgePrograms::forEachProgram(const std::function<void(GLuint program)>& fn) const {
+    fn(still);
+    fn(wave);
+}
+
+void EdgePrograms::use(const FrameState& frame) {
+    glState::useProgram(frame.waveProgress >= 0.0f ? wave : still);
+}
+
+HexFills rollFills(const Settings& settings, const hexGrid::Layout& layout, std::mt19937& rng) {
+    HexFills fills;
+    if (settings.renderMode == RenderMode::Procedural) {
+        fills.seed = static_cast<std::uint32_t>(rng());
+    } else {
+        fills.hexagons = hexGrid::generate(layout, rng);
+    }
+    return fills;
+}
+
+std::unique_ptr<HexScene> createHexScene(const Settings& settings, const hexGrid::Layout& layout, const HexFills& fills) {
+    std::unique_ptr<HexScene> scene = buildHexScene(settings, layout, fills);
+    if (scene) {
+        scene->createVertexArrays();
+    }
+    return scene;
+}
+
+std::unique_ptr<HexScene> buildHexScene(const Settings& settings, const hexGrid::Layout& layout, const HexFills& fills) {
+    switch (settings.renderMode) {
+    case RenderMode::Procedural:
+        return ProceduralScene::create(settings, layout, fills.seed);
+    case RenderMode::Instanced:
+        return InstancedScene::create(settings, layout, fills.hexagons);
+    case RenderMode::Baked:
+    default:
+        return BakedScene::create(settings, layout, fills.hexagons);
+    }
+}
@@ -0,0 +1,156 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "settings.h"
+#include "hexGrid.h"
+#include "utils.h"
+#include "streamBuffer.h"
+
+// per-frame values shared by every render mode
+struct FrameState {
+    float halfWidth;
+    float halfHeight;
+    glm::vec2 mousePos;   // in GL window coordinates (y up)
+    float waveProgress;   // negative while no wave is active
+    float waveX;
+
+    bool operator==(const FrameState&) const = default;
+};
+
+// How many pixels fill triangles are pushed out so neighbours overlap instead of leaving
+// single-sample cracks between them. 0 when multisampled, where the cracks can't show and
+// the overlap would blend translucent fills twice along every shared side
+float fillExpansion(const Settings& settings);
+
+// How far from the cursor and from the wave center an edge pixel can change, in pixels.
+// Both include half the edge quad and a pixel of multisample coverage on either side
+struct EdgeReach {
+    float cursor; // the fade is computed for the whole segment, its far end can be an edge length further away
+    float wave;   // the wave tints whole edges by their midpoint, half an edge away from its ends
+};
+EdgeReach edgeReach(const Settings& settings, const hexGrid::Layout& layout);
+
+// uniform buffer binding point of the "Frame" block
+inline constexpr GLuint frameBindingPoint = 1;
+
+// the "Frame" block of shaders/include/frame.glsl, std140
+struct FrameBlock {
+    float halfWidth;
+    float halfHeight;
+    glm::vec2 mousePos;
+    float barrierRadius;
+    float fadeArea;
+    float edgeWidth;
+    float waveX;
+    glm::vec4 waveColor;
+    float waveWidth;
+    float padding[3];
+};
+static_assert(sizeof(FrameBlock) == 64, "FrameBlock must match the std140 layout of the Frame block");
+
+// the block of frame, the rest of it comes from settings
+FrameBlock makeFrameBlock(const Settings& settings, const FrameState& frame);
+
+// points the "Frame" block of the program at frameBindingPoint
+void bindFrameBlock(GLuint program);
+
+// The per-frame values every program reads (resolution, cursor, barrier, wave), kept in
+// one uniform buffer. A frame costs a single upload instead of a dozen glUniform calls
+// per program, and programs switch without re-sending anything. The block is streamed,
+// an upload never waits for the frames before it to finish reading theirs.
+class FrameUniformBuffer {
+public:
+    explicit FrameUniformBuffer(const Settings& settings);
+    ~FrameUniformBuffer();
+
+    FrameUniformBuffer(const FrameUniformBuffer&) = delete;
+    FrameUniformBuffer& operator=(const FrameUniformBuffer&) = delete;
+
+    // uploads the block when the frame differs from the last one uploaded
+    void update(const FrameState& frame);
+
+private:
+    const Settings& settings;
+    std::unique_ptr<StreamBuffer> stream;
+    bool hasUploaded = false;
+    FrameState uploaded{};
+};
+
+// The program that shades edges, specialised for the frames it draws. The barrier
+// direction and the smoothing are fixed by the settings; the wave is compiled in only
+// for frames it crosses, so every other frame skips its math entirely.
+// Both variants are compiled up front, a wave starting never stalls on the compiler.
+class EdgePrograms {
+public:
+    // analyticAA selects coverage computed in the shader over plain multisampled quads.
+    // Returns nullptr if a variant fails to compile
+    static std::unique_ptr<EdgePrograms> create(const Settings& settings, const std::string& vertexPath,
+                                                const std::string& fragmentPath, bool analyticAA);
+
+    // calls fn with the program of every variant, to set the uniforms that never change
+    void forEachProgram(const std::function<void(GLuint program)>& fn) const;
+
+    // binds the variant for frame, its uniforms come from the Frame block
+    void use(const FrameState& frame);
+
+private:
+    EdgePrograms(const std::string& vertexPath, const std::string& fragmentPath) : variants(vertexPath, fragmentPath) {}
+
+    shaderUtils::ProgramVariants variants; // owns the programs
+    GLuint still = 0;
+    GLuint wave = 0;
+};
+
+// the wallpaper geometry of one render mode, drawn as a fill pass followed by an edge pass
+class HexScene {
+public:
+    virtual ~HexScene() = default;
+
+    // vertex arrays aren't shared between contexts, the scene gets them from this call
+    // on the thread that draws it, once, before the first draw
+    virtual void createVertexArrays() = 0;
+
+    virtual void drawFills(const FrameState& frame) = 0;
+    virtual void drawEdges(const FrameState& frame) = 0;
+
+    // the pixel coverage of every edge in the red channel, used to cache the edge layer.
+    // Only available when the scene was created with layer-cache on in reverse mode
+    virtual void drawEdgeCoverage(const FrameState& frame) = 0;
+
+    // false when the fill pass already contains the edges and can't be cached on its own
+    virtual bool cacheableFills() const { return true; }
+
+    // true when drawFills draws the edges as well, and drawEdges has nothing to do
+    virtual bool edgesInFillPass() const { return false; }
+
+    // uploads the fill masks of hexagons[first, first + count) after they changed, hexagons
+    // being the list the scene was built from. Only flags or indices are sent, the
+    // positions stay as they are. Returns false when the scene can't change its fills in
+    // place and has to be built again; a layer cache has to be invalidated either way
+    virtual bool refill(const std::vector<hexGrid::Hexagon>& /*hexagons*/, size_t /*first*/, size_t /*count*/) { return false; }
+};
+
+// what the holes of a pattern are rolled from: the hexagons for the modes that have
+// geometry, a seed for the procedural mode, which hashes its fills from it instead
+struct HexFills {
+    std::vector<hexGrid::Hexagon> hexagons;
+    std::uint32_t seed = 0;
+};
+
+// rolls a new pattern for settings.renderMode with rng
+HexFills rollFills(const Settings& settings, const hexGrid::Layout& layout, std::mt19937& rng);
+
+// builds the scene for settings.renderMode with the holes of fills.
+// Returns nullptr if its shaders fail to compile
+std::unique_ptr<HexScene> createHexScene(const Settings& settings, const hexGrid::Layout& layout, const HexFills& fills);
+
+// the same without the vertex arrays, for building on a context shared with the one that draws
+std::unique_ptr<HexScene> buildHexScene(const Settings& settings, const hexGrid::Layout& layout, const HexFills& fills);
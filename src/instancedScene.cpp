@@ -0,0 +1,181 @@
+#include "instancedScene.h"
+#include "utils.h"
+#include "palette.h"
+#include "glState.h"
+
+#include <algorithm>
+#include <iostream>
+
+// vertices emitted per instance: 6 triangles, and a quad for each spoke and border
+static constexpr GLsizei fillVerticesPerHexagon = 18;
+static constexpr GLsizei edgeVerticesPerHexagon = (hexGrid::spokeCount + hexGrid::borderCount) * 6;
+
+// the flags stream of a hexagon: fill mask in bits 0-5, owned borders in bits 6-11
+static std::uint32_t instanceFlags(const hexGrid::Hexagon& hexagon) {
+    return hexagon.fillMask | (hexagon.borderMask << 6);
+}
+
+
+std::unique_ptr<InstancedScene> InstancedScene::create(const Settings& settings, const hexGrid::Layout& layout, const std::vector<hexGrid::Hexagon>& hexagons) {
+    std::unique_ptr<InstancedScene> scene(new InstancedScene(settings));
+
+    // ---------- compile shaders ----------
+    // the quads leave room for analytic smoothing only when there are no samples to do it
+    const bool analyticAA = settings.MSAA == 0;
+
+    if (settings.singlePass) {
+        // the outlines are computed per pixel, there are no quads to multisample
+        scene->edgePrograms = EdgePrograms::create(settings, "instanced_wireframe_vertex.glsl", "wireframe_fragment.glsl", true);
+        if (!scene->edgePrograms) {
+            std::cerr << "Failed to compile instanced wireframe shaders!" << std::endl;
+            return nullptr;
+        }
+    } else {
+        scene->fillShaderProgram = shaderUtils::compileShaders("instanced_static_vertex.glsl", "static_fragment.glsl");
+        if (scene->fillShaderProgram == 0) {
+            std::cerr << "Failed to compile instanced static shaders!" << std::endl;
+            return nullptr;
+        }
+        scene->uploadConstants(scene->fillShaderProgram, layout);
+
+        scene->edgePrograms = EdgePrograms::create(settings, "instanced_edge_vertex.glsl", "edge_fragment.glsl", analyticAA);
+        if (!scene->edgePrograms) {
+            std::cerr << "Failed to compile instanced edge shaders!" << std::endl;
+            return nullptr;
+        }
+    }
+    scene->edgePrograms->forEachProgram([&](GLuint program) {
+        scene->uploadConstants(program, layout);
+    });
+
+    if (settings.layerCache && settings.barrier.reverse && !settings.singlePass) {
+        scene->edgeCoverageProgram = shaderUtils::compileShaders("instanced_edge_vertex.glsl", "edge_coverage_fragment.glsl",
+                                                                 analyticAA ? std::uint32_t{shaderUtils::FeatureAnalyticAA} : 0u);
+        if (scene->edgeCoverageProgram == 0) {
+            std::cerr << "Failed to compile instanced edge coverage shaders!" << std::endl;
+            return nullptr;
+        }
+        scene->uploadConstants(scene->edgeCoverageProgram, layout);
+    }
+
+    // ---------- instance streams ----------
+    std::vector<glm::vec2> centers;
+    std::vector<std::uint32_t> flags;
+    centers.reserve(hexagons.size());
+    flags.reserve(hexagons.size());
+    for (const hexGrid::Hexagon& hexagon : hexagons) {
+        centers.push_back(hexagon.center);
+        flags.push_back(instanceFlags(hexagon));
+    }
+    scene->instanceCount = static_cast<GLsizei>(hexagons.size());
+
+    glGenBuffers(1, &scene->centerBuffer);
+    glGenBuffers(1, &scene->flagBuffer);
+
+    glBindBuffer(GL_ARRAY_BUFFER, scene->centerBuffer);
+    if (!centers.empty()) {
+        glBufferData(GL_ARRAY_BUFFER,
+                     centers.size() * sizeof(glm::vec2),
+                     centers.data(),
+                     GL_STATIC_DRAW);
+    } else {
+        glBufferData(GL_ARRAY_BUFFER, 1, nullptr, GL_STATIC_DRAW);
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, scene->flagBuffer);
+    if (!flags.empty()) {
+        glBufferData(GL_ARRAY_BUFFER,
+                     flags.size() * sizeof(std::uint32_t),
+                     flags.data(),
+                     GL_DYNAMIC_DRAW);
+    } else {
+        glBufferData(GL_ARRAY_BUFFER, 1, nullptr, GL_DYNAMIC_DRAW);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    return scene;
+}
+
+void InstancedScene::createVertexArrays() {
+    glGenVertexArrays(1, &instanceVAO);
+    glState::bindVertexArray(instanceVAO);
+
+    // Center (location 0) vec2, advances once per hexagon
+    glBindBuffer(GL_ARRAY_BUFFER, centerBuffer);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(glm::vec2), (void*)0);
+    glVertexAttribDivisor(0, 1);
+    glEnableVertexAttribArray(0);
+
+    // Fill and border flags (location 1) uint, advances once per hexagon
+    glBindBuffer(GL_ARRAY_BUFFER, flagBuffer);
+    glVertexAttribIPointer(1, 1, GL_UNSIGNED_INT, sizeof(std::uint32_t), (void*)0);
+    glVertexAttribDivisor(1, 1);
+    glEnableVertexAttribArray(1);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+InstancedScene::~InstancedScene() {
+    glState::deleteProgram(fillShaderProgram);
+    glState::deleteProgram(edgeCoverageProgram);
+
+    glState::deleteVertexArray(instanceVAO);
+    glDeleteBuffers(1, &centerBuffer);
+    glDeleteBuffers(1, &flagBuffer);
+}
+
+bool InstancedScene::refill(const std::vector<hexGrid::Hexagon>& hexagons, size_t first, size_t count) {
+    if (first >= hexagons.size() || first >= static_cast<size_t>(instanceCount)) {
+        return true;
+    }
+    count = std::min({ count, hexagons.size() - first, static_cast<size_t>(instanceCount) - first });
+
+    // the instances are in the order of hexagons, the changed ones are one range
+    std::vector<std::uint32_t> flags;
+    flags.reserve(count);
+    for (size_t i = first; i < first + count; i++) {
+        flags.push_back(instanceFlags(hexagons[i]));
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, flagBuffer);
+    glBufferSubData(GL_ARRAY_BUFFER, first * sizeof(std::uint32_t), flags.size() * sizeof(std::uint32_t), flags.data());
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    return true;
+}
+
+void InstancedScene::uploadConstants(GLuint program, const hexGrid::Layout& layout) const {
+    glState::useProgram(program);
+
+    glUniform2fv(glGetUniformLocation(program, "corners"), hexGrid::CornerCount, &layout.corners[0].x);
+    glUniform1f(glGetUniformLocation(program, "fillExpansion"), fillExpansion(settings));
+    bindPaletteBlock(program);
+    bindFrameBlock(program);
+}
+
+void InstancedScene::drawFills(const FrameState& frame) {
+    if (settings.singlePass) {
+        edgePrograms->use(frame);
+    } else {
+        glState::useProgram(fillShaderProgram);
+    }
+
+    glState::bindVertexArray(instanceVAO);
+    glDrawArraysInstanced(GL_TRIANGLES, 0, fillVerticesPerHexagon, instanceCount);
+}
+
+void InstancedScene::drawEdges(const FrameState& frame) {
+    if (settings.singlePass) {
+        return;
+    }
+
+    edgePrograms->use(frame);
+
+    glState::bindVertexArray(instanceVAO);
+    glDrawArraysInstanced(GL_TRIANGLES, 0, edgeVerticesPerHexagon, instanceCount);
+}
+
+void InstancedScene::drawEdgeCoverage(const FrameState& frame) {
+    glState::useProgram(edgeCoverageProgram);
+
+    glState::bindVertexArray(instanceVAO);
+    glDrawArraysInstanced(GL_TRIANGLES, 0, edgeVerticesPerHexagon, instanceCount);
+}
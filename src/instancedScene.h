@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+
+#include "hexScene.h"
+
+// One instance per hexagon; the vertex shaders rebuild the 6 fill triangles
+// and the edge quads from gl_VertexID. In single pass mode the fill triangles
+// draw the outlines and there is no edge pass.
+// The centers and the flags (fill mask in bits 0-5, owned borders in bits 6-11)
+// are separate instance streams, refill() only rewrites flags.
+
+class InstancedScene : public HexScene {
+public:
+    static std::unique_ptr<InstancedScene> create(const Settings& settings, const hexGrid::Layout& layout, const std::vector<hexGrid::Hexagon>& hexagons);
+    ~InstancedScene() override;
+
+    void createVertexArrays() override;
+
+    void drawFills(const FrameState& frame) override;
+    void drawEdges(const FrameState& frame) override;
+    void drawEdgeCoverage(const FrameState& frame) override;
+
+    bool cacheableFills() const override { return !settings.singlePass; }
+    bool edgesInFillPass() const override { return settings.singlePass; }
+
+    bool refill(const std::vector<hexGrid::Hexagon>& hexagons, size_t first, size_t count) override;
+
+private:
+    explicit InstancedScene(const Settings& settings) : settings(settings) {}
+
+    // the hexagon shape never changes, it is set once after linking
+    void uploadConstants(GLuint program, const hexGrid::Layout& layout) const;
+
+    const Settings& settings;
+
+    GLuint fillShaderProgram = 0; // not used in single pass mode
+    GLuint edgeCoverageProgram = 0;
+    std::unique_ptr<EdgePrograms> edgePrograms; // the edge pass, or the fill pass in single pass mode
+
+    GLuint instanceVAO = 0;
+    GLuint centerBuffer = 0, flagBuffer = 0;
+    GLsizei instanceCount = 0;
+};
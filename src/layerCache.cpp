@@ -0,0 +1,192 @@
+#include "layerCache.h"
+#include "palette.h"
+#include "utils.h"
+#include "glState.h"
+
+#include <iostream>
+
+
+// ---------- RenderTarget ----------
+std::unique_ptr<RenderTarget> RenderTarget::create(const RenderTargetDesc& desc) {
+    std::unique_ptr<RenderTarget> owner(new RenderTarget(desc));
+    RenderTarget& target = *owner;
+
+    glGenTextures(1, &target.texture);
+    glBindTexture(GL_TEXTURE_2D, target.texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, desc.internalFormat, desc.width, desc.height, 0,
+                 desc.internalFormat == GL_R8 ? GL_RED : GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    glGenFramebuffers(1, &target.fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, target.fbo);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, target.texture, 0);
+    bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+
+    if (complete && desc.samples > 0) {
+        glGenRenderbuffers(1, &target.msRenderbuffer);
+        glBindRenderbuffer(GL_RENDERBUFFER, target.msRenderbuffer);
+        glRenderbufferStorageMultisample(GL_RENDERBUFFER, desc.samples, desc.internalFormat, desc.width, desc.height);
+        glBindRenderbuffer(GL_RENDERBUFFER, 0);
+
+        glGenFramebuffers(1, &target.msFBO);
+        glBindFramebuffer(GL_FRAMEBUFFER, target.msFBO);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, target.msRenderbuffer);
+        complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    if (!complete) {
+        std::cerr << "Failed to create render target!" << std::endl;
+        return nullptr;
+    }
+    return owner;
+}
+
+RenderTarget::~RenderTarget() {
+    glDeleteFramebuffers(1, &msFBO);
+    glDeleteRenderbuffers(1, &msRenderbuffer);
+    glDeleteFramebuffers(1, &fbo);
+    glDeleteTextures(1, &texture);
+}
+
+void RenderTarget::bind() const {
+    glBindFramebuffer(GL_FRAMEBUFFER, msFBO != 0 ? msFBO : fbo);
+}
+
+void RenderTarget::resolve() const {
+    if (msFBO != 0) {
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, msFBO);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, fbo);
+        glBlitFramebuffer(0, 0, desc.width, desc.height, 0, 0, desc.width, desc.height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    }
+}
+
+
+// ---------- LayerCache ----------
+std::unique_ptr<LayerCache> LayerCache::create(const Settings& settings, const hexGrid::Layout& layout, int width, int height) {
+    std::unique_ptr<LayerCache> cache(new LayerCache(settings, width, height));
+
+    cache->layerProgram = shaderUtils::compileShaders("fullscreen_vertex.glsl", "layer_fragment.glsl");
+    if (cache->layerProgram == 0) {
+        std::cerr << "Failed to compile layer shaders!" << std::endl;
+        return nullptr;
+    }
+    glState::useProgram(cache->layerProgram);
+    glUniform1i(glGetUniformLocation(cache->layerProgram, "layer"), 0);
+
+    cache->fillLayer = RenderTarget::create(RenderTargetDesc{width, height, GL_RGBA8, settings.MSAA});
+    if (cache->fillLayer == nullptr) {
+        return nullptr;
+    }
+
+    if (settings.barrier.reverse) {
+        // the smoothing is already in the cached coverage
+        cache->edgeComposite = EdgePrograms::create(settings, "fullscreen_vertex.glsl", "edge_composite_fragment.glsl", false);
+        if (!cache->edgeComposite) {
+            std::cerr << "Failed to compile edge composite shaders!" << std::endl;
+            return nullptr;
+        }
+
+        // the composite finds the covered segment from the grid, set it up once
+        cache->edgeComposite->forEachProgram([&](GLuint program) {
+            glState::useProgram(program);
+            glUniform1i(glGetUniformLocation(program, "coverageLayer"), 0);
+            glUniform1f(glGetUniformLocation(program, "hexagonWidth"), layout.width);
+            glUniform1f(glGetUniformLocation(program, "sliceWidth"), layout.sliceWidth);
+            glUniform1f(glGetUniformLocation(program, "yDistance"), layout.yDistance);
+            glUniform2fv(glGetUniformLocation(program, "corners"), hexGrid::CornerCount, &layout.corners[0].x);
+            bindPaletteBlock(program);
+            bindFrameBlock(program);
+        });
+
+        cache->edgeLayer = RenderTarget::create(RenderTargetDesc{width, height, GL_R8, settings.MSAA});
+        if (cache->edgeLayer == nullptr) {
+            return nullptr;
+        }
+    }
+
+    glGenVertexArrays(1, &cache->emptyVAO);
+
+    return cache;
+}
+
+LayerCache::~LayerCache() {
+    glState::deleteProgram(layerProgram);
+    glState::deleteVertexArray(emptyVAO);
+}
+
+void LayerCache::beginLayer(const RenderTarget& layer) {
+    layer.bind();
+    glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+    glClear(GL_COLOR_BUFFER_BIT);
+}
+
+void LayerCache::render(HexScene& scene, const FrameState& frame) {
+    GLint target = 0;
+    GLfloat clearColor[4];
+    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &target);
+    glGetFloatv(GL_COLOR_CLEAR_VALUE, clearColor);
+
+    // the layers are always rendered whole, even when only a damaged region is redrawn
+    GLboolean scissor = glIsEnabled(GL_SCISSOR_TEST);
+    glDisable(GL_SCISSOR_TEST);
+
+    // fills, kept premultiplied so the layer can go over any background
+    beginLayer(*fillLayer);
+    glState::blendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    scene.drawFills(frame);
+    fillLayer->resolve();
+
+    // edge coverage, colors and masks are applied when compositing.
+    // Where quads meet at a corner the larger coverage wins
+    if (edgeLayer != nullptr) {
+        beginLayer(*edgeLayer);
+        glState::blendEquation(GL_MAX);
+        scene.drawEdgeCoverage(frame);
+        glState::blendEquation(GL_FUNC_ADD);
+        edgeLayer->resolve();
+    }
+
+    glState::blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glBindFramebuffer(GL_FRAMEBUFFER, target);
+    glClearColor(clearColor[0], clearColor[1], clearColor[2], clearColor[3]);
+    if (scissor) {
+        glEnable(GL_SCISSOR_TEST);
+    }
+
+    valid = true;
+}
+
+void LayerCache::drawFills(HexScene& scene, const FrameState& frame) {
+    if (!valid) {
+        render(scene, frame);
+    }
+
+    // fill layer over the cleared background
+    glState::bindVertexArray(emptyVAO);
+    glState::useProgram(layerProgram);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, fillLayer->texture);
+    glState::blendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    glState::blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void LayerCache::drawEdges(HexScene& scene, const FrameState& frame) {
+    if (edgeLayer == nullptr) {
+        // nothing to cache, only the few edges near the cursor are visible
+        scene.drawEdges(frame);
+        return;
+    }
+
+    // cached edges, masked by the barrier and tinted by the wave
+    glState::bindVertexArray(emptyVAO);
+    edgeComposite->use(frame);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, edgeLayer->texture);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
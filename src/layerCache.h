@@ -0,0 +1,87 @@
+#pragma once
+
+#include <memory>
+#include <glad/glad.h>
+
+#include "settings.h"
+#include "hexGrid.h"
+#include "hexScene.h"
+
+// size, format and sample count of a render target
+struct RenderTargetDesc {
+    int width;
+    int height;
+    GLenum internalFormat; // GL_RGBA8 or GL_R8
+    int samples;           // 0 draws straight into the texture
+
+    bool operator==(const RenderTargetDesc&) const = default;
+};
+
+// A texture layers are drawn into and later read from. With samples it is drawn in a
+// multisampled buffer and resolved into the texture before it is read.
+struct RenderTarget {
+    // nullptr if the framebuffer can't be completed
+    static std::unique_ptr<RenderTarget> create(const RenderTargetDesc& desc);
+    ~RenderTarget();
+
+    RenderTarget(const RenderTarget&) = delete;
+    RenderTarget& operator=(const RenderTarget&) = delete;
+
+    RenderTargetDesc desc{};
+    GLuint texture = 0;
+    GLuint fbo = 0;
+    GLuint msRenderbuffer = 0;
+    GLuint msFBO = 0;
+
+    // binds the framebuffer that is drawn in
+    void bind() const;
+    // copies the multisampled buffer into the texture, nothing to do without samples
+    void resolve() const;
+
+private:
+    explicit RenderTarget(const RenderTargetDesc& desc) : desc(desc) {}
+};
+
+// Renders the parts of the wallpaper that don't move into resolved textures once,
+// and composites them every frame with a full-screen pass:
+//  - the fill layer, always
+//  - the full edge layer in reverse barrier mode, where the barrier and the wave
+//    are applied while compositing; otherwise the edges are drawn live on top
+// Stale layers are re-rendered on the next draw after invalidate().
+class LayerCache {
+public:
+    static std::unique_ptr<LayerCache> create(const Settings& settings, const hexGrid::Layout& layout, int width, int height);
+    ~LayerCache();
+
+    LayerCache(const LayerCache&) = delete;
+    LayerCache& operator=(const LayerCache&) = delete;
+
+    // call when anything baked into the layers changed (colors, geometry, resolution)
+    void invalidate() { valid = false; }
+
+    // draws scene's fills into the bound framebuffer, rendering the layers first when they are stale
+    void drawFills(HexScene& scene, const FrameState& frame);
+    // draws scene's edges into the bound framebuffer, after drawFills
+    void drawEdges(HexScene& scene, const FrameState& frame);
+
+private:
+    LayerCache(const Settings& settings, int width, int height)
+        : settings(settings), width(width), height(height) {}
+
+    // binds the framebuffer the layer is drawn in and clears it
+    void beginLayer(const RenderTarget& layer);
+
+    void render(HexScene& scene, const FrameState& frame);
+
+    const Settings& settings;
+    int width;
+    int height;
+    bool valid = false;
+
+    std::unique_ptr<RenderTarget> fillLayer;
+    std::unique_ptr<RenderTarget> edgeLayer; // only in reverse barrier mode
+
+    GLuint layerProgram = 0;
+    std::unique_ptr<EdgePrograms> edgeComposite;
+    GLuint emptyVAO = 0;
+};
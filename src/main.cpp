@@ -7,6 +7,9 @@
 
 #define GLFW_EXPOSE_NATIVE_WIN32
 #include <glad/glad.h>
+#ifdef SHAHRFLOW_VULKAN
+#include <vulkan/vulkan.h> // before GLFW, which declares its Vulkan functions only then
+#endif
 #include <GLFW/glfw3.h>
 #include <GLFW/glfw3native.h>
 #include <glm/glm.hpp>
@@ -15,34 +18,57 @@
 #include <chrono>
 #include <thread>
 #include <cmath>
+#include <algorithm>
 #include <functional>
 #include <random>
 #include <vector>
 #include <memory>
+#include <optional>
 
 #include "settings.h"
 #include "desktopUtils.h"
 #include "trayUtils.h"
 #include "utils.h"
+#include "hexGrid.h"
+#include "hexScene.h"
+#include "proceduralScene.h"
+#include "palette.h"
+#include "layerCache.h"
+#include "passList.h"
+#include "scenePasses.h"
+#include "damageTracker.h"
+#include "glState.h"
+#include "modernGL.h"
+#include "gles.h"
+#include "sceneBuilder.h"
+
+#ifdef SHAHRFLOW_VULKAN
+#include "vulkanRenderer.h"
+#else
+// never created in builds without the Vulkan backend, it only keeps the main loop free of #ifdefs
+struct VulkanRenderer {
+    void reseed(std::uint32_t) {}
+    bool drawFrame(const FrameState&, const PaletteBlend&, const Color&) { return false; }
+};
+#endif
 
 
 // --- Random engine (single global engine, seeded once) ---
 static std::random_device rd_global;
 static std::mt19937 gen_global(rd_global());
 
-static float randomUniformGlobal(float start, float end) {
-    std::uniform_real_distribution<> dist(start, end);
-    return static_cast<float>(dist(gen_global));
-}
-
 // main window
 GLFWwindow* window;
 
+// set from the tray menu, the main loop starts building a new pattern
+static bool shuffleRequested = false;
+
 // handles tray events (unchanged)
 static LRESULT CALLBACK WindowProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) {
     if (msg == WM_TRAYICON) {
         if (lParam == WM_RBUTTONUP) {
             HMENU menu = CreatePopupMenu();
+            AppendMenu(menu, MF_STRING, 2, L"Shuffle pattern");
             AppendMenu(menu, MF_STRING, 1, L"Quit");
             POINT cursorPos;
             GetCursorPos(&cursorPos);
@@ -52,6 +78,8 @@ static LRESULT CALLBACK WindowProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lP
 
             if (selection == 1) {
                 glfwSetWindowShouldClose(window, GLFW_TRUE);
+            } else if (selection == 2) {
+                shuffleRequested = true;
             }
         }
     }
@@ -59,41 +87,42 @@ static LRESULT CALLBACK WindowProc(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lP
     return DefWindowProcW(hwnd, msg, wParam, lParam);
 }
 
-// Vertex structure for static geometry (triangles)
-struct Vertex {
-    float x;
-    float y;
-    float r;
-    float g;
-    float b;
-    float a;
-
-    Vertex(float x, float y) : x(x), y(y), r(0.0f), g(0.0f), b(0.0f), a(0.0f) {}
-    Vertex(float x, float y, float r, float g, float b, float a) : x(x), y(y), r(r), g(g), b(b), a(a) {}
-    Vertex(float x, float y, Color color) : x(x), y(y), r(color[0]), g(color[1]), b(color[2]), a(color[3]) {}
-};
+// everything OpenGL needs once the window's context is current
+static bool initOpenGL(Settings& settings) {
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+        std::cerr << "Failed to initialize GLAD\n";
+        return false;
+    }
 
-// Vertex structure for dynamic edge geometry
-struct EdgeVertex {
-    float x;
-    float y;
-    float r;
-    float g;
-    float b;
-    float a;
-    float edgeP1_x;
-    float edgeP1_y;
-    float edgeP2_x;
-    float edgeP2_y;
-
-    EdgeVertex(float x, float y, Color color, const glm::vec2& p1, const glm::vec2& p2) 
-        : x(x), y(y), r(color[0]), g(color[1]), b(color[2]), a(color[3]),
-          edgeP1_x(p1.x), edgeP1_y(p1.y), edgeP2_x(p2.x), edgeP2_y(p2.y) {}
-};
+    // ---------- OpenGL ES 3.0 has functions glad only loads for desktop GL 3.1+ ----------
+    if (settings.openGLES) {
+        if (!gles::load((GLADloadproc)glfwGetProcAddress)) {
+            std::cerr << "Failed to initialize OpenGL ES 3.0\n";
+            return false;
+        }
+        gles::adaptSettings(settings);
+    }
 
-// Note: Edge data now stored as vertex attributes in EdgeVertex struct
+    // ---------- Shaders are embedded, a development copy can stand in for them ----------
+    shaderUtils::setShaderDirectory(settings.shaderDirectory);
 
-// Note: point-to-segment distance calculation moved to GPU shaders
+    // ---------- Linked programs kept next to settings.json, later starts skip compiling ----------
+    if (settings.programCache) {
+        shaderUtils::enableProgramCache("shader-cache", (GLADloadproc)glfwGetProcAddress);
+    }
+
+    // ---------- GL 4.4+ paths, the 3.3 ones stay in use when the driver lacks them ----------
+    // the indirect draws are only used with indirect-draw on, buffer storage always
+    modernGL::load((GLADloadproc)glfwGetProcAddress);
+
+    // always on for multisampled targets in ES, which doesn't have the switch
+    if (!gles::active()) {
+        glEnable(GL_MULTISAMPLE);
+    }
+    glEnable(GL_BLEND);
+    glState::blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    return true;
+}
 
 int main() {
     // ---------- GLFW / GL init ----------
@@ -102,6 +131,8 @@ int main() {
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 
+    // measured once: the window, the layout and every screen-sized target follow from it,
+    // a display change takes effect on the next start
     const int iWidth = GetSystemMetrics(SM_CXVIRTUALSCREEN);
     const int iHeight = GetSystemMetrics(SM_CYVIRTUALSCREEN);
     const float Width = static_cast<float>(iWidth);
@@ -115,8 +146,31 @@ int main() {
 
     Settings settings = loadSettings("settings.json");
 
-    // using multi-sample anti-aliasing
-    glfwWindowHint(GLFW_SAMPLES, settings.MSAA);
+    // Vulkan instead, the window gets no context at all
+    bool useVulkan = settings.backend == Backend::Vulkan;
+#ifndef SHAHRFLOW_VULKAN
+    if (useVulkan) {
+        std::cerr << "This build has no Vulkan backend, drawing with OpenGL" << std::endl;
+        useVulkan = false;
+    }
+#endif
+    if (useVulkan && settings.renderMode != RenderMode::Procedural) {
+        std::cerr << "The Vulkan backend only draws the procedural mode, drawing with OpenGL" << std::endl;
+        useVulkan = false;
+    }
+
+    if (useVulkan) {
+        glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
+    } else if (settings.openGLES) {
+        // OpenGL ES 3.0 instead, created through EGL
+        glfwWindowHint(GLFW_CLIENT_API, GLFW_OPENGL_ES_API);
+        glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_EGL_CONTEXT_API);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 0);
+    }
+
+    // using multi-sample anti-aliasing, partial redraws multisample their own offscreen copy
+    glfwWindowHint(GLFW_SAMPLES, settings.partialRedraw ? 0 : settings.MSAA);
 
     window = glfwCreateWindow(iWidth, iHeight, "ShahrFlow", nullptr, nullptr);
     if (!window) {
@@ -131,13 +185,15 @@ int main() {
     using GameTickFunc = void(*)(const float, const float, float&);
     GameTickFunc tickFunc;
 
-    glfwMakeContextCurrent(window);
+    // Vulkan picks its present mode from vsync instead of a swap interval
+    if (!useVulkan) {
+        glfwMakeContextCurrent(window);
+        glfwSwapInterval(settings.vsync ? 1 : 0);
+    }
 
     if (settings.vsync) {
-        glfwSwapInterval(1);
         tickFunc = [](const float, const float, float&) {};
     } else {
-        glfwSwapInterval(0);
         tickFunc = [](const float frameTime, const float stepInterval, float& fractionalTime) {
             if (frameTime < stepInterval) {
                 float totalSleepTime = (stepInterval - frameTime) + fractionalTime;
@@ -148,15 +204,10 @@ int main() {
         };
     }
 
-    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
-        std::cerr << "Failed to initialize GLAD\n";
+    if (!useVulkan && !initOpenGL(settings)) {
         return -1;
     }
 
-    glEnable(GL_MULTISAMPLE);
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-
     bool waveActive = false;
     float waveStartTime = 0.0f;
     float waveTravelDistance = Width + settings.wave.width;
@@ -166,190 +217,90 @@ int main() {
     // ---------- mouse ----------
     double mouseX = 0.0, mouseY = 0.0;
 
-    // ---------- geometry storage ----------
-    std::vector<Vertex> triangleVertices; // static: generated once at startup (fills)
-    std::vector<EdgeVertex> edgeVertices; // static: edge geometry with edge data (generated once)
-
-    // ---------- helpers to add geometry ----------
-    auto addTriangleStatic = [&](const glm::vec2& p1, const glm::vec2& p2, const glm::vec2& p3, Color color) {
-        triangleVertices.emplace_back(p1.x, p1.y, color[0], color[1], color[2], color[3]);
-        triangleVertices.emplace_back(p2.x, p2.y, color[0], color[1], color[2], color[3]);
-        triangleVertices.emplace_back(p3.x, p3.y, color[0], color[1], color[2], color[3]);
-    };
-
-    // Helper to generate edge geometry with edge data stored as vertex attributes
-    auto addEdgeGeometry = [&](const glm::vec2& p1, const glm::vec2& p2, Color color, float width) {
-        glm::vec2 edge = glm::normalize(p2 - p1);
-        glm::vec2 normal(-edge.y, edge.x);
-        glm::vec2 offset = normal * (width * 0.5f);
-
-        glm::vec2 q1 = p1 + offset;
-        glm::vec2 q2 = p2 + offset;
-        glm::vec2 q3 = p2 - offset;
-        glm::vec2 q4 = p1 - offset;
-
-        // First triangle
-        edgeVertices.emplace_back(q1.x, q1.y, color, p1, p2);
-        edgeVertices.emplace_back(q2.x, q2.y, color, p1, p2);
-        edgeVertices.emplace_back(q3.x, q3.y, color, p1, p2);
-
-        // Second triangle
-        edgeVertices.emplace_back(q1.x, q1.y, color, p1, p2);
-        edgeVertices.emplace_back(q3.x, q3.y, color, p1, p2);
-        edgeVertices.emplace_back(q4.x, q4.y, color, p1, p2);
-    };
-
-    // Note: Wave effects will be handled in shaders as well
-
-    // This builds the triangles (with randomization applied once) and stores the edges for outlines.
-    auto insertHexagonsInit = [&]() -> void {
-        const float hexagonWidth = 1.7320508075688772f * settings.hexagonSize;
-        const float hexagonSliceWidth = 0.8660254037844386f * settings.hexagonSize;
-        const float hexagonHeight = 2.0f * settings.hexagonSize;
-        const float hexagonYDis = 1.5f * settings.hexagonSize;
-        const float hexagonHalfSize = 0.5f * settings.hexagonSize;
-        const int hexagonsInWidth = static_cast<int>(Width / hexagonWidth) + 2;
-        const int hexagonsInHeight = static_cast<int>(Height / hexagonYDis) + 1;
-
-        triangleVertices.reserve(hexagonsInHeight * hexagonsInWidth * 18); // 6 triangles per hexagon, 3 verts each
-        edgeVertices.reserve(hexagonsInHeight * hexagonsInWidth * 108); // 3 edges per triangle, 6 verts per edge
-
-        for (int iy = 0; iy <= hexagonsInHeight; iy++) {
-            float y = iy * hexagonYDis;
-            for (float x = (iy % 2 ? 0.0f : hexagonSliceWidth); x <= Width + hexagonWidth; x += hexagonWidth) {
-                glm::vec2 c(x, y);
-                glm::vec2 top(x, y + settings.hexagonSize);
-                glm::vec2 bottom(x, y - settings.hexagonSize);
-                glm::vec2 leftTop(x - hexagonSliceWidth, y + hexagonHalfSize);
-                glm::vec2 rightTop(x + hexagonSliceWidth, y + hexagonHalfSize);
-                glm::vec2 leftBottom(x - hexagonSliceWidth, y - hexagonHalfSize);
-                glm::vec2 rightBottom(x + hexagonSliceWidth, y - hexagonHalfSize);
-
-                // For each of the 6 triangles: compute random once and add static triangle + push edges
-                auto addTriWithOneTimeRandom = [&](const glm::vec2& p1, const glm::vec2& p2, const glm::vec2& p3, Color baseFill) {
-                    float triangleY = (p1.y + p2.y + p3.y) / 3.0f;
-                    float normalizedY = triangleY / Height;
-                    // float probability = normalizedY;
-                    float probability = pow(normalizedY, 2.0f);
-                    // float probability = 1.0f / (1.0f + exp(-10.0f * (normalizedY - 0.5f)));
-                    Color fill = baseFill;
-                    if (randomUniformGlobal(0.0f, 1.0f) < probability) {
-                        fill = {0.0f, 0.0f, 0.0f, 0.0f};
-                    }
-                    addTriangleStatic(p1, p2, p3, fill);
-
-                    // generate edge geometry once (with edge data as vertex attributes)
-                    addEdgeGeometry(p1, p2, settings.edges.color, settings.edges.width);
-                    addEdgeGeometry(p2, p3, settings.edges.color, settings.edges.width);
-                    addEdgeGeometry(p3, p1, settings.edges.color, settings.edges.width);
-                };
-
-                addTriWithOneTimeRandom(c, top, leftTop, settings.cube.topColor);
-                addTriWithOneTimeRandom(c, top, rightTop, settings.cube.topColor);
-                addTriWithOneTimeRandom(c, leftTop, leftBottom, settings.cube.leftColor);
-                addTriWithOneTimeRandom(c, rightTop, rightBottom, settings.cube.rightColor);
-                addTriWithOneTimeRandom(c, bottom, leftBottom, settings.cube.leftColor);
-                addTriWithOneTimeRandom(c, bottom, rightBottom, settings.cube.rightColor);
-            }
-        }
-    };
-
-    // ---------- Create VAOs / VBOs ----------
-    GLuint staticVAO = 0, staticVBO = 0;
-    GLuint edgeVAO = 0, edgeVBO = 0;
-
-    glGenVertexArrays(1, &staticVAO);
-    glGenBuffers(1, &staticVBO);
-
-    glGenVertexArrays(1, &edgeVAO);
-    glGenBuffers(1, &edgeVBO);
-
-    // ---------- Build static geometry (triangles and edges) once ----------
-    insertHexagonsInit(); // fills triangleVertices and edgeVertices (one-time)
-
-    // Bind static VAO & VBO and upload triangle data
-    glBindVertexArray(staticVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, staticVBO);
-    if (!triangleVertices.empty()) {
-        glBufferData(GL_ARRAY_BUFFER,
-                     triangleVertices.size() * sizeof(Vertex),
-                     triangleVertices.data(),
-                     GL_STATIC_DRAW);
-    } else {
-        // ensure there's at least an empty buffer
-        glBufferData(GL_ARRAY_BUFFER, 1, nullptr, GL_STATIC_DRAW);
+    // ---------- Build the hexagon grid once (fills are randomized here) ----------
+    // a fixed seed fixes the first pattern, shuffles are rolled from seeds drawn from the same engine
+    if (settings.seed != 0) {
+        gen_global.seed(settings.seed);
     }
-
-    // layout: position (location 0) vec2
-    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
-    glEnableVertexAttribArray(0);
-
-    // layout: color (location 1) vec4
-    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, r));
-    glEnableVertexAttribArray(1);
-
-    glBindVertexArray(0);
-
-    // Setup edge VAO (for outlines with edge data)
-    glBindVertexArray(edgeVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, edgeVBO);
-    if (!edgeVertices.empty()) {
-        glBufferData(GL_ARRAY_BUFFER,
-                     edgeVertices.size() * sizeof(EdgeVertex),
-                     edgeVertices.data(),
-                     GL_STATIC_DRAW);
+    const hexGrid::Layout layout = hexGrid::makeLayout(settings.hexagonSize, Width, Height);
+    HexFills fills = rollFills(settings, layout, gen_global);
+
+    // ---------- What draws the frames: Vulkan's renderer, or the scene and its GL passes ----------
+    std::unique_ptr<VulkanRenderer> vulkanRenderer;
+    std::unique_ptr<PaletteBuffer> paletteBuffer;
+    std::unique_ptr<FrameUniformBuffer> frameUniforms;
+    std::unique_ptr<HexScene> scene;
+    std::unique_ptr<LayerCache> layerCache;
+    std::unique_ptr<DamageTracker> damageTracker;
+    std::unique_ptr<RetainedFramebuffer> retainedFramebuffer;
+    std::unique_ptr<PassList> framePasses;
+
+    if (useVulkan) {
+        // ---------- The procedural pass as SPIR-V, presented to a surface of the window ----------
+#ifdef SHAHRFLOW_VULKAN
+        VulkanRenderer::Surface surface;
+        std::uint32_t extensionCount = 0;
+        const char** extensions = glfwGetRequiredInstanceExtensions(&extensionCount);
+        surface.instanceExtensions.assign(extensions, extensions + extensionCount);
+        surface.create = [](VkInstance instance, VkSurfaceKHR* windowSurface) {
+            return glfwCreateWindowSurface(instance, window, nullptr, windowSurface);
+        };
+        vulkanRenderer = VulkanRenderer::create(surface, settings, layout, iWidth, iHeight, fills.seed);
+#endif
+        if (!vulkanRenderer) {
+            std::cerr << "Failed to create the Vulkan renderer, \"backend\": \"opengl\" draws without it" << std::endl;
+            return -1;
+        }
     } else {
-        glBufferData(GL_ARRAY_BUFFER, 1, nullptr, GL_STATIC_DRAW);
-    }
+        // ---------- Colors, shared by every program through one uniform block ----------
+        paletteBuffer = std::make_unique<PaletteBuffer>(settings.palettes);
 
-    // Position (location 0) vec2
-    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(EdgeVertex), (void*)0);
-    glEnableVertexAttribArray(0);
+        // ---------- Cursor, wave and resolution, also shared through one uniform block ----------
+        frameUniforms = std::make_unique<FrameUniformBuffer>(settings);
 
-    // Color (location 1) vec4
-    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(EdgeVertex), (void*)offsetof(EdgeVertex, r));
-    glEnableVertexAttribArray(1);
-
-    // Edge point 1 (location 2) vec2
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(EdgeVertex), (void*)offsetof(EdgeVertex, edgeP1_x));
-    glEnableVertexAttribArray(2);
+        // ---------- Upload geometry and compile shaders for the selected render mode ----------
+        scene = createHexScene(settings, layout, fills);
+        if (!scene) {
+            return -1;
+        }
 
-    // Edge point 2 (location 3) vec2
-    glVertexAttribPointer(3, 2, GL_FLOAT, GL_FALSE, sizeof(EdgeVertex), (void*)offsetof(EdgeVertex, edgeP2_x));
-    glEnableVertexAttribArray(3);
+        // ---------- Static layers rendered once and composited every frame ----------
+        if (settings.layerCache && scene->cacheableFills()) {
+            layerCache = LayerCache::create(settings, layout, iWidth, iHeight);
+            if (!layerCache) {
+                std::cerr << "Layer cache unavailable, drawing the scene directly" << std::endl;
+            }
+        }
 
-    glBindVertexArray(0);
+        // ---------- Damage tracking, only the changed regions are redrawn ----------
+        if (settings.partialRedraw) {
+            retainedFramebuffer = RetainedFramebuffer::create(iWidth, iHeight, settings.MSAA);
+            if (retainedFramebuffer) {
+                damageTracker = std::make_unique<DamageTracker>(settings, layout, iWidth, iHeight);
+            } else {
+                std::cerr << "Partial redraw unavailable, redrawing every frame in full" << std::endl;
+            }
+        }
 
-    // ---------- compile shaders ----------
-    GLuint staticShaderProgram = shaderUtils::compileShaders("shaders/static_vertex.glsl", "shaders/static_fragment.glsl");
-    if (staticShaderProgram == 0) {
-        std::cerr << "Failed to compile static shaders!" << std::endl;
-        return -1;
-    }
-    
-    GLuint edgeShaderProgram = shaderUtils::compileShaders("shaders/edge_vertex.glsl", "shaders/edge_fragment.glsl");
-    if (edgeShaderProgram == 0) {
-        std::cerr << "Failed to compile edge shaders!" << std::endl;
-        return -1;
+        // ---------- Passes of a frame: static triangles (fills), then the edge outlines on top ----------
+        // passes that can't change a pixel in a frame are skipped, new effects are added here
+        framePasses = std::make_unique<PassList>();
+        addScenePasses(*framePasses, settings, layout, *scene, layerCache.get(), iWidth, iHeight);
     }
 
-    // Static shader uniforms
-    GLint staticHalfWidthLocation  = glGetUniformLocation(staticShaderProgram, "halfWidth");
-    GLint staticHalfHeightLocation = glGetUniformLocation(staticShaderProgram, "halfHeight");
-    
-    // Edge shader uniforms
-    GLint edgeHalfWidthLocation  = glGetUniformLocation(edgeShaderProgram, "halfWidth");
-    GLint edgeHalfHeightLocation = glGetUniformLocation(edgeShaderProgram, "halfHeight");
-    GLint mousePosLocation = glGetUniformLocation(edgeShaderProgram, "mousePos");
-    GLint barrierRadiusLocation = glGetUniformLocation(edgeShaderProgram, "barrierRadius");
-    GLint fadeAreaLocation = glGetUniformLocation(edgeShaderProgram, "fadeArea");
-    GLint reverseModeLocation = glGetUniformLocation(edgeShaderProgram, "reverseMode");
-    
-    // Wave effect uniforms
-    GLint waveProgressLocation = glGetUniformLocation(edgeShaderProgram, "waveProgress");
-    GLint waveXLocation = glGetUniformLocation(edgeShaderProgram, "waveX");
-    GLint waveWidthLocation = glGetUniformLocation(edgeShaderProgram, "waveWidth");
-    GLint waveColorLocation = glGetUniformLocation(edgeShaderProgram, "waveColor");
+    // ---------- Shuffled patterns are rolled on a worker, created by the first shuffle ----------
+    // a scene that can't refill is built there as well, the current one keeps drawing
+    std::unique_ptr<SceneBuilder> sceneBuilder;
+
+    // ---------- Idle detection ----------
+    // the picture only changes with the cursor, the wave and the palette. While none of them moves
+    // nothing is drawn and the loop blocks until input arrives or the next wave or palette is due
+    WatchMouseInput(hwnd);
+    FrameState presentedFrame{};
+    // the blend Vulkan drew last, GL's palette buffer keeps its own
+    PaletteBlend drawnPalette{ static_cast<size_t>(-1), static_cast<size_t>(-1), -1.0f };
+    bool hasPresented = false;
+    float previousTime = 0.0f;
 
     // frame timing
     const float stepInterval = 1.0f / settings.targetFPS;
@@ -374,11 +325,12 @@ int main() {
 
         float glfwTime = static_cast<float>(glfwGetTime()); // or your timer system
 
-        // Start a new wave every interval
-        if (!waveActive && fmod(glfwTime, waveInterval) < dt) {
+        // Start a new wave every interval, on the first frame past each multiple of it
+        if (!waveActive && std::floor(glfwTime / waveInterval) > std::floor(previousTime / waveInterval)) {
             waveActive = true;
             waveStartTime = glfwTime;
         }
+        previousTime = glfwTime;
 
         // Check if current wave finished
         if (waveActive && (glfwTime - waveStartTime) > waveDuration) {
@@ -387,55 +339,112 @@ int main() {
 
         glfwGetCursorPos(window, &mouseX, &mouseY);
 
-        glClearColor(settings.backgroundColor[0], settings.backgroundColor[1], settings.backgroundColor[2], settings.backgroundColor[3]);
-        glClear(GL_COLOR_BUFFER_BIT);
-
-        // draw static triangles (fills) with static shader
-        glUseProgram(staticShaderProgram);
-        glUniform1f(staticHalfWidthLocation, HalfWidth);
-        glUniform1f(staticHalfHeightLocation, HalfHeight);
-        
-        glBindVertexArray(staticVAO);
-        glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(triangleVertices.size()));
-        glBindVertexArray(0);
-
-        // draw edge outlines with edge shader
-        glUseProgram(edgeShaderProgram);
-        glUniform1f(edgeHalfWidthLocation, HalfWidth);
-        glUniform1f(edgeHalfHeightLocation, HalfHeight);
-        
-        // Set mouse position and barrier settings for edge rendering
-        glm::vec2 mousePos(static_cast<float>(mouseX), Height - static_cast<float>(mouseY));
-        glUniform2f(mousePosLocation, mousePos.x, mousePos.y);
-        glUniform1f(barrierRadiusLocation, settings.barrier.radius);
-        glUniform1f(fadeAreaLocation, settings.barrier.fadeArea);
-        glUniform1i(reverseModeLocation, settings.barrier.reverse ? 1 : 0);
-        
-        // Set wave effect uniforms
+        // pick the palettes of the time of day, only the blend factor moves while they fade
+        SYSTEMTIME localTime;
+        GetLocalTime(&localTime);
+        float secondsOfDay = localTime.wHour * 3600.0f + localTime.wMinute * 60.0f + localTime.wSecond + localTime.wMilliseconds * 1e-3f;
+        PaletteBlend paletteBlend = evaluatePalettes(settings.palettes, settings.paletteFade, secondsOfDay);
+        bool paletteChanged = vulkanRenderer ? paletteBlend != drawnPalette : paletteBuffer->update(paletteBlend);
+        drawnPalette = paletteBlend;
+
+        // a new pattern or a rebuilt scene is swapped in between two frames, the old one drew its last frame already
+        bool sceneChanged = false;
+        if (shuffleRequested) {
+            if (!sceneBuilder) {
+                sceneBuilder = SceneBuilder::create(window, settings, layout);
+            }
+            sceneBuilder->roll(static_cast<std::uint32_t>(gen_global()));
+            shuffleRequested = false;
+        }
+        if (sceneBuilder) {
+            // the procedural scene hashes its holes from the seed, the others upload the new
+            // fill flags in place, only a scene that can't is built again in the background
+            if (std::optional<HexFills> rolled = sceneBuilder->takeFills()) {
+                fills = std::move(*rolled);
+                if (vulkanRenderer) {
+                    vulkanRenderer->reseed(fills.seed);
+                    sceneChanged = true;
+                } else if (auto* procedural = dynamic_cast<ProceduralScene*>(scene.get())) {
+                    procedural->reseed(fills.seed);
+                    sceneChanged = true;
+                } else if (scene->refill(fills.hexagons, 0, fills.hexagons.size())) {
+                    sceneChanged = true;
+                } else {
+                    sceneBuilder->build(fills);
+                }
+            }
+            if (std::unique_ptr<HexScene> rebuilt = sceneBuilder->takeScene()) {
+                scene.swap(rebuilt);
+                framePasses = std::make_unique<PassList>();
+                addScenePasses(*framePasses, settings, layout, *scene, layerCache.get(), iWidth, iHeight);
+                sceneChanged = true;
+            }
+        }
+
+        if ((paletteChanged || sceneChanged) && layerCache) {
+            layerCache->invalidate();
+        }
+
+        FrameState frame{};
+        frame.halfWidth = HalfWidth;
+        frame.halfHeight = HalfHeight;
+        frame.mousePos = glm::vec2(static_cast<float>(mouseX), Height - static_cast<float>(mouseY));
         if (waveActive) {
-            float waveProgress = (glfwTime - waveStartTime) / waveDuration;
-            float waveX = -settings.wave.width * 0.5f + waveProgress * (Width + settings.wave.width);
-            
-            glUniform1f(waveProgressLocation, waveProgress);
-            glUniform1f(waveXLocation, waveX);
-            glUniform1f(waveWidthLocation, settings.wave.width);
-            glUniform4f(waveColorLocation, settings.wave.color[0], settings.wave.color[1], 
-                       settings.wave.color[2], settings.wave.color[3]);
+            frame.waveProgress = (glfwTime - waveStartTime) / waveDuration;
+            frame.waveX = -settings.wave.width * 0.5f + frame.waveProgress * (Width + settings.wave.width);
+        } else {
+            frame.waveProgress = -1.0f;
+            frame.waveX = -999999.0f;
+        }
+
+        // identical to what is on screen, sleep until something can change
+        if (hasPresented && !paletteChanged && !sceneChanged && frame == presentedFrame) {
+            float untilWave = (std::floor(glfwTime / waveInterval) + 1.0f) * waveInterval - glfwTime;
+            float untilPalette = secondsUntilPaletteChange(settings.palettes, settings.paletteFade, secondsOfDay);
+            glfwWaitEventsTimeout(std::min(untilWave, untilPalette));
+            continue;
+        }
+
+        Color backgroundColor = blendedBackground(settings.palettes, paletteBlend);
+        if (vulkanRenderer) {
+            // recorded, submitted and presented in one, the present mode paces it
+            if (!vulkanRenderer->drawFrame(frame, paletteBlend, backgroundColor)) {
+                break;
+            }
         } else {
-            // Disable wave effect
-            glUniform1f(waveProgressLocation, -1.0f);
-            glUniform1f(waveXLocation, -999999.0f);
-            glUniform1f(waveWidthLocation, 0.0f);
-            glUniform4f(waveColorLocation, 0.0f, 0.0f, 0.0f, 0.0f);
+            glClearColor(backgroundColor[0], backgroundColor[1], backgroundColor[2], backgroundColor[3]);
+            frameUniforms->update(frame);
+
+            bool drawn = true;
+            if (damageTracker) {
+                // the changes were all off screen, keep showing the last frame
+                drawn = damageTracker->addFrame(frame, paletteChanged || sceneChanged);
+                if (drawn) {
+                    std::vector<DamageRect> regions = damageTracker->regionsFor(retainedFramebuffer->age());
+                    retainedFramebuffer->bind();
+                    glEnable(GL_SCISSOR_TEST);
+                    for (const DamageRect& region : regions) {
+                        glScissor(region.x, region.y, region.width, region.height);
+                        glClear(GL_COLOR_BUFFER_BIT);
+                        framePasses->execute(frame);
+                    }
+                    glDisable(GL_SCISSOR_TEST);
+                    // a back buffer of unknown age gets the whole frame
+                    retainedFramebuffer->present(regions, damageTracker->regionsFor(gles::bufferAge()));
+                }
+            } else {
+                glClear(GL_COLOR_BUFFER_BIT);
+                framePasses->execute(frame);
+            }
+
+            if (drawn) {
+                glfwSwapBuffers(window);
+            }
         }
-        
-        glBindVertexArray(edgeVAO);
-        glDrawArrays(GL_TRIANGLES, 0, static_cast<GLsizei>(edgeVertices.size()));
-        glBindVertexArray(0);
 
-        glUseProgram(0);
+        presentedFrame = frame;
+        hasPresented = true;
 
-        glfwSwapBuffers(window);
         glfwPollEvents();
 
         tickFunc(dt, stepInterval, fractionalTime);
@@ -448,13 +457,14 @@ int main() {
     RemoveTrayIcon(hwnd);
     DestroyIcon(hIcon);
 
-    glDeleteProgram(staticShaderProgram);
-    glDeleteProgram(edgeShaderProgram);
-
-    glDeleteVertexArrays(1, &staticVAO);
-    glDeleteBuffers(1, &staticVBO);
-    glDeleteVertexArrays(1, &edgeVAO);
-    glDeleteBuffers(1, &edgeVBO);
+    sceneBuilder.reset();
+    retainedFramebuffer.reset();
+    framePasses.reset();
+    layerCache.reset();
+    scene.reset();
+    frameUniforms.reset();
+    paletteBuffer.reset();
+    vulkanRenderer.reset();
 
     glfwDestroyWindow(window);
     glfwTerminate();
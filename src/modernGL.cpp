@@ -0,0 +1,141 @@
+#include "modernGL.h"
+
+#include <cstring>
+#include <iostream>
+#include <type_traits>
+
+
+namespace modernGL {
+    PFNGLBUFFERSTORAGEPROC bufferStorage = nullptr;
+    PFNGLCREATEBUFFERSPROC createBuffers = nullptr;
+    PFNGLNAMEDBUFFERSTORAGEPROC namedBufferStorage = nullptr;
+    PFNGLNAMEDBUFFERSUBDATAPROC namedBufferSubData = nullptr;
+    PFNGLCREATEVERTEXARRAYSPROC createVertexArrays = nullptr;
+    PFNGLVERTEXARRAYVERTEXBUFFERPROC vertexArrayVertexBuffer = nullptr;
+    PFNGLVERTEXARRAYATTRIBFORMATPROC vertexArrayAttribFormat = nullptr;
+    PFNGLVERTEXARRAYATTRIBIFORMATPROC vertexArrayAttribIFormat = nullptr;
+    PFNGLVERTEXARRAYATTRIBBINDINGPROC vertexArrayAttribBinding = nullptr;
+    PFNGLENABLEVERTEXARRAYATTRIBPROC enableVertexArrayAttrib = nullptr;
+    PFNGLCREATETEXTURESPROC createTextures = nullptr;
+    PFNGLTEXTUREBUFFERRANGEPROC textureBufferRange = nullptr;
+    PFNGLBINDTEXTUREUNITPROC bindTextureUnit = nullptr;
+    PFNGLMULTIDRAWARRAYSINDIRECTPROC multiDrawArraysIndirect = nullptr;
+    PFNGLMULTIDRAWELEMENTSINDIRECTPROC multiDrawElementsIndirect = nullptr;
+    PFNGLVERTEXARRAYELEMENTBUFFERPROC vertexArrayElementBuffer = nullptr;
+    PFNGLDISPATCHCOMPUTEPROC dispatchCompute = nullptr;
+    PFNGLMEMORYBARRIERPROC memoryBarrier = nullptr;
+}
+
+static bool loaded = false;
+static bool computeLoaded = false;
+
+static bool hasExtension(const char* name) {
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (GLint i = 0; i < count; ++i) {
+        const GLubyte* extension = glGetStringi(GL_EXTENSIONS, i);
+        if (extension && std::strcmp(reinterpret_cast<const char*>(extension), name) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool modernGL::load(GLADloadproc load) {
+    // some loaders hand out entry points the context can't call, so the version decides
+    bool storageSupported = GLVersion.major > 4 || (GLVersion.major == 4 && GLVersion.minor >= 4) ||
+                            hasExtension("GL_ARB_buffer_storage");
+    if (storageSupported) {
+        bufferStorage = reinterpret_cast<PFNGLBUFFERSTORAGEPROC>(load("glBufferStorage"));
+    }
+
+    bool supported = GLVersion.major > 4 || (GLVersion.major == 4 && GLVersion.minor >= 5) ||
+                     (hasExtension("GL_ARB_direct_state_access") && hasExtension("GL_ARB_multi_draw_indirect") &&
+                      hasExtension("GL_ARB_buffer_storage"));
+    if (!supported) {
+        std::cerr << "Direct state access or indirect draws unsupported, using the GL 3.3 path" << std::endl;
+        return false;
+    }
+
+    createBuffers = reinterpret_cast<PFNGLCREATEBUFFERSPROC>(load("glCreateBuffers"));
+    namedBufferStorage = reinterpret_cast<PFNGLNAMEDBUFFERSTORAGEPROC>(load("glNamedBufferStorage"));
+    namedBufferSubData = reinterpret_cast<PFNGLNAMEDBUFFERSUBDATAPROC>(load("glNamedBufferSubData"));
+    createVertexArrays = reinterpret_cast<PFNGLCREATEVERTEXARRAYSPROC>(load("glCreateVertexArrays"));
+    vertexArrayVertexBuffer = reinterpret_cast<PFNGLVERTEXARRAYVERTEXBUFFERPROC>(load("glVertexArrayVertexBuffer"));
+    vertexArrayAttribFormat = reinterpret_cast<PFNGLVERTEXARRAYATTRIBFORMATPROC>(load("glVertexArrayAttribFormat"));
+    vertexArrayAttribIFormat = reinterpret_cast<PFNGLVERTEXARRAYATTRIBIFORMATPROC>(load("glVertexArrayAttribIFormat"));
+    vertexArrayAttribBinding = reinterpret_cast<PFNGLVERTEXARRAYATTRIBBINDINGPROC>(load("glVertexArrayAttribBinding"));
+    enableVertexArrayAttrib = reinterpret_cast<PFNGLENABLEVERTEXARRAYATTRIBPROC>(load("glEnableVertexArrayAttrib"));
+    createTextures = reinterpret_cast<PFNGLCREATETEXTURESPROC>(load("glCreateTextures"));
+    textureBufferRange = reinterpret_cast<PFNGLTEXTUREBUFFERRANGEPROC>(load("glTextureBufferRange"));
+    bindTextureUnit = reinterpret_cast<PFNGLBINDTEXTUREUNITPROC>(load("glBindTextureUnit"));
+    multiDrawArraysIndirect = reinterpret_cast<PFNGLMULTIDRAWARRAYSINDIRECTPROC>(load("glMultiDrawArraysIndirect"));
+    multiDrawElementsIndirect = reinterpret_cast<PFNGLMULTIDRAWELEMENTSINDIRECTPROC>(load("glMultiDrawElementsIndirect"));
+    vertexArrayElementBuffer = reinterpret_cast<PFNGLVERTEXARRAYELEMENTBUFFERPROC>(load("glVertexArrayElementBuffer"));
+
+    loaded = createBuffers && namedBufferStorage && namedBufferSubData && createVertexArrays && vertexArrayVertexBuffer &&
+             vertexArrayAttribFormat && vertexArrayAttribIFormat && vertexArrayAttribBinding && enableVertexArrayAttrib &&
+             createTextures && textureBufferRange && bindTextureUnit && multiDrawArraysIndirect &&
+             multiDrawElementsIndirect && vertexArrayElementBuffer;
+    if (!loaded) {
+        std::cerr << "Failed to load direct state access functions, using the GL 3.3 path" << std::endl;
+        return false;
+    }
+
+    bool computeSupported = GLVersion.major > 4 || (GLVersion.major == 4 && GLVersion.minor >= 3) ||
+                            (hasExtension("GL_ARB_compute_shader") && hasExtension("GL_ARB_shader_storage_buffer_object"));
+    if (computeSupported) {
+        dispatchCompute = reinterpret_cast<PFNGLDISPATCHCOMPUTEPROC>(load("glDispatchCompute"));
+        memoryBarrier = reinterpret_cast<PFNGLMEMORYBARRIERPROC>(load("glMemoryBarrier"));
+        computeLoaded = dispatchCompute && memoryBarrier;
+    }
+    return true;
+}
+
+bool modernGL::available() {
+    return loaded;
+}
+
+bool modernGL::bufferStorageAvailable() {
+    return bufferStorage != nullptr;
+}
+
+bool modernGL::computeAvailable() {
+    return computeLoaded;
+}
+
+
+// ---------- CommandBuffer ----------
+template <typename Command>
+modernGL::CommandBuffer<Command>::CommandBuffer(GLsizei capacity) : capacity(capacity) {
+    createBuffers(1, &commandBuffer);
+    namedBufferStorage(commandBuffer, capacity * sizeof(Command), nullptr, GL_DYNAMIC_STORAGE_BIT);
+}
+
+template <typename Command>
+modernGL::CommandBuffer<Command>::~CommandBuffer() {
+    glDeleteBuffers(1, &commandBuffer);
+}
+
+template <typename Command>
+void modernGL::CommandBuffer<Command>::set(GLsizei first, const Command* commands, GLsizei count) {
+    if (first < 0 || count <= 0 || first + count > capacity) {
+        return;
+    }
+    namedBufferSubData(commandBuffer, first * sizeof(Command), count * sizeof(Command), commands);
+}
+
+template <typename Command>
+void modernGL::CommandBuffer<Command>::draw(GLenum mode, GLsizei first, GLsizei count) const {
+    // the one binding DSA can't replace, draws read their commands through it
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+    const void* offset = reinterpret_cast<const void*>(static_cast<std::uintptr_t>(first) * sizeof(Command));
+    if constexpr (std::is_same_v<Command, DrawElementsCommand>) {
+        multiDrawElementsIndirect(mode, GL_UNSIGNED_INT, offset, count, sizeof(Command));
+    } else {
+        multiDrawArraysIndirect(mode, offset, count, sizeof(Command));
+    }
+}
+
+template class modernGL::CommandBuffer<modernGL::DrawArraysCommand>;
+template class modernGL::CommandBuffer<modernGL::DrawElementsCommand>;
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <cstdint>
+#include <glad/glad.h>
+
+// GL 4.3 / ARB_multi_draw_indirect and ARB_texture_buffer_range, not part of the 3.3 loader
+#define GL_DRAW_INDIRECT_BUFFER            0x8F3F
+#define GL_TEXTURE_BUFFER_OFFSET_ALIGNMENT 0x919F
+// GL 4.3 / ARB_shader_storage_buffer_object and ARB_compute_shader
+#define GL_SHADER_STORAGE_BUFFER                  0x90D2
+#define GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT 0x90DF
+#define GL_TEXTURE_FETCH_BARRIER_BIT              0x00000008
+#define GL_COMMAND_BARRIER_BIT                    0x00000040
+// GL 4.4 / ARB_buffer_storage
+#define GL_DYNAMIC_STORAGE_BIT             0x0100
+#define GL_MAP_PERSISTENT_BIT              0x0040
+#define GL_MAP_COHERENT_BIT                0x0080
+
+// GL 4.5 direct state access and GL 4.3 multi-draw-indirect, beyond the 3.3 core glad
+// loads. Everything here is null until load() succeeds, callers keep their 3.3 path
+// for contexts without it.
+namespace modernGL {
+    // looks the functions up with load. Needs GL 4.5, or ARB_direct_state_access,
+    // ARB_multi_draw_indirect and ARB_buffer_storage; returns false and loads nothing without them
+    bool load(GLADloadproc load);
+    bool available();
+    // glBufferStorage alone, GL 4.4 or ARB_buffer_storage. Loaded by load() even when the rest is missing
+    bool bufferStorageAvailable();
+    // compute shaders and storage buffers on top, GL 4.3 or their ARB extensions
+    bool computeAvailable();
+
+    typedef void (APIENTRYP PFNGLBUFFERSTORAGEPROC)(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags);
+    typedef void (APIENTRYP PFNGLCREATEBUFFERSPROC)(GLsizei n, GLuint* buffers);
+    typedef void (APIENTRYP PFNGLNAMEDBUFFERSTORAGEPROC)(GLuint buffer, GLsizeiptr size, const void* data, GLbitfield flags);
+    typedef void (APIENTRYP PFNGLNAMEDBUFFERSUBDATAPROC)(GLuint buffer, GLintptr offset, GLsizeiptr size, const void* data);
+    typedef void (APIENTRYP PFNGLCREATEVERTEXARRAYSPROC)(GLsizei n, GLuint* arrays);
+    typedef void (APIENTRYP PFNGLVERTEXARRAYVERTEXBUFFERPROC)(GLuint vaobj, GLuint bindingindex, GLuint buffer, GLintptr offset, GLsizei stride);
+    typedef void (APIENTRYP PFNGLVERTEXARRAYATTRIBFORMATPROC)(GLuint vaobj, GLuint attribindex, GLint size, GLenum type, GLboolean normalized, GLuint relativeoffset);
+    typedef void (APIENTRYP PFNGLVERTEXARRAYATTRIBIFORMATPROC)(GLuint vaobj, GLuint attribindex, GLint size, GLenum type, GLuint relativeoffset);
+    typedef void (APIENTRYP PFNGLVERTEXARRAYATTRIBBINDINGPROC)(GLuint vaobj, GLuint attribindex, GLuint bindingindex);
+    typedef void (APIENTRYP PFNGLENABLEVERTEXARRAYATTRIBPROC)(GLuint vaobj, GLuint index);
+    typedef void (APIENTRYP PFNGLCREATETEXTURESPROC)(GLenum target, GLsizei n, GLuint* textures);
+    typedef void (APIENTRYP PFNGLTEXTUREBUFFERRANGEPROC)(GLuint texture, GLenum internalformat, GLuint buffer, GLintptr offset, GLsizeiptr size);
+    typedef void (APIENTRYP PFNGLBINDTEXTUREUNITPROC)(GLuint unit, GLuint texture);
+    typedef void (APIENTRYP PFNGLMULTIDRAWARRAYSINDIRECTPROC)(GLenum mode, const void* indirect, GLsizei drawcount, GLsizei stride);
+    typedef void (APIENTRYP PFNGLMULTIDRAWELEMENTSINDIRECTPROC)(GLenum mode, GLenum type, const void* indirect, GLsizei drawcount, GLsizei stride);
+    typedef void (APIENTRYP PFNGLVERTEXARRAYELEMENTBUFFERPROC)(GLuint vaobj, GLuint buffer);
+    typedef void (APIENTRYP PFNGLDISPATCHCOMPUTEPROC)(GLuint num_groups_x, GLuint num_groups_y, GLuint num_groups_z);
+    typedef void (APIENTRYP PFNGLMEMORYBARRIERPROC)(GLbitfield barriers);
+
+    extern PFNGLBUFFERSTORAGEPROC bufferStorage;
+    extern PFNGLCREATEBUFFERSPROC createBuffers;
+    extern PFNGLNAMEDBUFFERSTORAGEPROC namedBufferStorage;
+    extern PFNGLNAMEDBUFFERSUBDATAPROC namedBufferSubData;
+    extern PFNGLCREATEVERTEXARRAYSPROC createVertexArrays;
+    extern PFNGLVERTEXARRAYVERTEXBUFFERPROC vertexArrayVertexBuffer;
+    extern PFNGLVERTEXARRAYATTRIBFORMATPROC vertexArrayAttribFormat;
+    extern PFNGLVERTEXARRAYATTRIBIFORMATPROC vertexArrayAttribIFormat;
+    extern PFNGLVERTEXARRAYATTRIBBINDINGPROC vertexArrayAttribBinding;
+    extern PFNGLENABLEVERTEXARRAYATTRIBPROC enableVertexArrayAttrib;
+    extern PFNGLCREATETEXTURESPROC createTextures;
+    extern PFNGLTEXTUREBUFFERRANGEPROC textureBufferRange;
+    extern PFNGLBINDTEXTUREUNITPROC bindTextureUnit;
+    extern PFNGLMULTIDRAWARRAYSINDIRECTPROC multiDrawArraysIndirect;
+    extern PFNGLMULTIDRAWELEMENTSINDIRECTPROC multiDrawElementsIndirect;
+    extern PFNGLVERTEXARRAYELEMENTBUFFERPROC vertexArrayElementBuffer;
+    extern PFNGLDISPATCHCOMPUTEPROC dispatchCompute;
+    extern PFNGLMEMORYBARRIERPROC memoryBarrier;
+
+    // the record glMultiDrawArraysIndirect reads per draw
+    struct DrawArraysCommand {
+        GLuint count;
+        GLuint instanceCount; // 0 skips the draw
+        GLuint first;
+        GLuint baseInstance;
+    };
+    static_assert(sizeof(DrawArraysCommand) == 16, "laid out as the GL spec defines it");
+
+    // the record glMultiDrawElementsIndirect reads per draw, for GL_UNSIGNED_INT indices
+    struct DrawElementsCommand {
+        GLuint count;
+        GLuint instanceCount; // 0 skips the draw
+        GLuint firstIndex;
+        GLint baseVertex;
+        GLuint baseInstance;
+    };
+    static_assert(sizeof(DrawElementsCommand) == 20, "laid out as the GL spec defines it");
+
+    // Draw commands in a buffer the CPU rewrites with set() and a shader may write as well.
+    // Every draw() issues the asked for commands with a single multi-draw-indirect call
+    template <typename Command>
+    class CommandBuffer {
+    public:
+        explicit CommandBuffer(GLsizei capacity);
+        ~CommandBuffer();
+
+        CommandBuffer(const CommandBuffer&) = delete;
+        CommandBuffer& operator=(const CommandBuffer&) = delete;
+
+        GLuint buffer() const { return commandBuffer; }
+
+        // replaces count commands starting at first
+        void set(GLsizei first, const Command* commands, GLsizei count);
+
+        // draws count commands starting at first with the bound program and vertex array
+        void draw(GLenum mode, GLsizei first, GLsizei count) const;
+
+    private:
+        GLuint commandBuffer = 0;
+        GLsizei capacity;
+    };
+
+    using DrawCommandBuffer = CommandBuffer<DrawArraysCommand>;
+    using ElementCommandBuffer = CommandBuffer<DrawElementsCommand>; // the vertex array's element buffer holds the indices
+}
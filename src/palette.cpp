@@ -0,0 +1,115 @@
+#include "palette.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <limits>
+
+static constexpr float secondsPerDay = 86400.0f;
+
+static void writeSlots(float (&slots)[PaletteSlotCount][4], const Settings::Palette& palette) {
+    std::memcpy(slots[PaletteTop], palette.cube.topColor.data(), sizeof(slots[0]));
+    std::memcpy(slots[PaletteLeft], palette.cube.leftColor.data(), sizeof(slots[0]));
+    std::memcpy(slots[PaletteRight], palette.cube.rightColor.data(), sizeof(slots[0]));
+    std::memcpy(slots[PaletteEdge], palette.edgeColor.data(), sizeof(slots[0]));
+}
+
+
+PaletteBlend evaluatePalettes(const std::vector<Settings::Palette>& palettes, float fade, float secondsOfDay) {
+    if (palettes.size() < 2) {
+        return { 0, 0, 1.0f };
+    }
+
+    // the palette that started last, wrapping around to yesterday's last one before the first start
+    size_t current = palettes.size() - 1;
+    for (size_t i = 0; i < palettes.size(); i++) {
+        if (palettes[i].start <= secondsOfDay) {
+            current = i;
+        }
+    }
+    size_t previous = (current + palettes.size() - 1) % palettes.size();
+
+    float sinceStart = std::fmod(secondsOfDay - palettes[current].start + secondsPerDay, secondsPerDay);
+    if (fade <= 0.0f || sinceStart >= fade) {
+        return { current, current, 1.0f };
+    }
+    return { previous, current, sinceStart / fade };
+}
+
+float secondsUntilPaletteChange(const std::vector<Settings::Palette>& palettes, float fade, float secondsOfDay) {
+    if (palettes.size() < 2) {
+        return std::numeric_limits<float>::infinity();
+    }
+
+    PaletteBlend blend = evaluatePalettes(palettes, fade, secondsOfDay);
+    if (blend.from != blend.to) {
+        return 0.0f;
+    }
+
+    // the palette after the current one takes over at its start
+    size_t next = (blend.to + 1) % palettes.size();
+    return std::fmod(palettes[next].start - secondsOfDay + secondsPerDay, secondsPerDay);
+}
+
+Color blendedBackground(const std::vector<Settings::Palette>& palettes, const PaletteBlend& blend) {
+    const Color& from = palettes[blend.from].backgroundColor;
+    const Color& to = palettes[blend.to].backgroundColor;
+    Color color;
+    for (size_t i = 0; i < color.size(); i++) {
+        color[i] = from[i] + (to[i] - from[i]) * blend.factor;
+    }
+    return color;
+}
+
+PaletteBlock makePaletteBlock(const std::vector<Settings::Palette>& palettes, const PaletteBlend& blend) {
+    PaletteBlock block{};
+    writeSlots(block.fromColors, palettes[blend.from]);
+    writeSlots(block.toColors, palettes[blend.to]);
+    block.factor = blend.factor;
+    return block;
+}
+
+void bindPaletteBlock(GLuint program) {
+    GLuint blockIndex = glGetUniformBlockIndex(program, "Palette");
+    if (blockIndex != GL_INVALID_INDEX) {
+        glUniformBlockBinding(program, blockIndex, paletteBindingPoint);
+    }
+}
+
+PaletteBuffer::PaletteBuffer(const std::vector<Settings::Palette>& palettes) : palettes(palettes) {
+    glGenBuffers(1, &ubo);
+    glBindBuffer(GL_UNIFORM_BUFFER, ubo);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(PaletteBlock), nullptr, GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+    glBindBufferBase(GL_UNIFORM_BUFFER, paletteBindingPoint, ubo);
+
+    update({ 0, 0, 1.0f });
+}
+
+PaletteBuffer::~PaletteBuffer() {
+    glDeleteBuffers(1, &ubo);
+}
+
+bool PaletteBuffer::update(const PaletteBlend& blend) {
+    if (blend == uploaded) {
+        return false;
+    }
+
+    // in the middle of a fade only the factor moves
+    if (blend.from == uploaded.from && blend.to == uploaded.to) {
+        glBindBuffer(GL_UNIFORM_BUFFER, ubo);
+        glBufferSubData(GL_UNIFORM_BUFFER, offsetof(PaletteBlock, factor), sizeof(float), &blend.factor);
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+        uploaded = blend;
+        return true;
+    }
+
+    PaletteBlock block = makePaletteBlock(palettes, blend);
+    glBindBuffer(GL_UNIFORM_BUFFER, ubo);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(PaletteBlock), &block);
+    glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+    uploaded = blend;
+    return true;
+}
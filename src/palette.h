@@ -0,0 +1,66 @@
+#pragma once
+
+#include <vector>
+#include <glad/glad.h>
+
+#include "settings.h"
+
+// Colors live in one uniform block shared by every program instead of being
+// baked into the vertices. The block holds the two palettes of the current
+// crossfade, the shaders mix them, so a theme change costs one small upload.
+
+// slots of the palette block: the cube faces (same order as hexGrid::Face), then the edges
+enum PaletteSlot { PaletteTop, PaletteLeft, PaletteRight, PaletteEdge, PaletteSlotCount };
+
+// uniform buffer binding point of the "Palette" block
+inline constexpr GLuint paletteBindingPoint = 0;
+
+// which two scheduled palettes are shown and how far the fade between them went
+struct PaletteBlend {
+    size_t from;
+    size_t to;
+    float factor; // 0 shows `from`, 1 shows `to`
+
+    bool operator==(const PaletteBlend&) const = default;
+};
+
+// every palette is shown from its start time until the next one starts, fading in over `fade` seconds
+PaletteBlend evaluatePalettes(const std::vector<Settings::Palette>& palettes, float fade, float secondsOfDay);
+
+// seconds until the blend starts moving again, 0 while a fade is running and
+// infinity when there is only one palette
+float secondsUntilPaletteChange(const std::vector<Settings::Palette>& palettes, float fade, float secondsOfDay);
+
+// the clear color isn't read by any shader, it is mixed on the CPU
+Color blendedBackground(const std::vector<Settings::Palette>& palettes, const PaletteBlend& blend);
+
+// std140 image of the "Palette" uniform block
+struct PaletteBlock {
+    float fromColors[PaletteSlotCount][4];
+    float toColors[PaletteSlotCount][4];
+    float factor;
+    float padding[3];
+};
+
+// the block showing blend, for renderers that upload it themselves
+PaletteBlock makePaletteBlock(const std::vector<Settings::Palette>& palettes, const PaletteBlend& blend);
+
+// points the "Palette" block of the program at paletteBindingPoint
+void bindPaletteBlock(GLuint program);
+
+class PaletteBuffer {
+public:
+    explicit PaletteBuffer(const std::vector<Settings::Palette>& palettes);
+    ~PaletteBuffer();
+
+    PaletteBuffer(const PaletteBuffer&) = delete;
+    PaletteBuffer& operator=(const PaletteBuffer&) = delete;
+
+    // uploads the block when the blend changed since the last call, returns whether it did
+    bool update(const PaletteBlend& blend);
+
+private:
+    const std::vector<Settings::Palette>& palettes;
+    GLuint ubo = 0;
+    PaletteBlend uploaded{ static_cast<size_t>(-1), static_cast<size_t>(-1), -1.0f };
+};
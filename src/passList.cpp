@@ -0,0 +1,15 @@
+#include "passList.h"
+
+
+// ---------- PassList ----------
+void PassList::addPass(std::unique_ptr<RenderPass> pass) {
+    passes.push_back(std::move(pass));
+}
+
+void PassList::execute(const FrameState& frame) {
+    for (const std::unique_ptr<RenderPass>& pass : passes) {
+        if (pass->contributes(frame)) {
+            pass->execute(frame);
+        }
+    }
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include "hexScene.h"
+
+// One step of a frame, drawing into the bound framebuffer. Passes report every frame
+// whether they would change anything.
+class RenderPass {
+public:
+    virtual ~RenderPass() = default;
+
+    // false when the pass can't change a single pixel this frame, it is skipped
+    virtual bool contributes(const FrameState& frame) const { return true; }
+
+    virtual void execute(const FrameState& frame) = 0;
+};
+
+// The passes of a frame, run in the order they are added. There is no dependency tracking:
+// a pass draws into whatever is bound and keeps its own targets. Each frame only the passes
+// that contribute run, so an idle pass costs one contributes() call.
+class PassList {
+public:
+    PassList() = default;
+
+    PassList(const PassList&) = delete;
+    PassList& operator=(const PassList&) = delete;
+
+    void addPass(std::unique_ptr<RenderPass> pass);
+
+    // runs the passes that contribute this frame
+    void execute(const FrameState& frame);
+
+private:
+    std::vector<std::unique_ptr<RenderPass>> passes;
+};
@@ -0,0 +1,56 @@
+#include "proceduralScene.h"
+#include "utils.h"
+#include "palette.h"
+#include "glState.h"
+
+#include <iostream>
+
+
+std::unique_ptr<ProceduralScene> ProceduralScene::create(const Settings& settings, const hexGrid::Layout& layout, std::uint32_t seed) {
+    std::unique_ptr<ProceduralScene> scene(new ProceduralScene(settings));
+
+    // fills and outlines are computed per pixel, always smoothed analytically
+    scene->programs = EdgePrograms::create(settings, "fullscreen_vertex.glsl", "procedural_fragment.glsl", true);
+    if (!scene->programs) {
+        std::cerr << "Failed to compile procedural shaders!" << std::endl;
+        return nullptr;
+    }
+
+    // the grid never changes, set it up once
+    scene->programs->forEachProgram([&](GLuint program) {
+        glState::useProgram(program);
+        glUniform1f(glGetUniformLocation(program, "hexagonWidth"), layout.width);
+        glUniform1f(glGetUniformLocation(program, "sliceWidth"), layout.sliceWidth);
+        glUniform1f(glGetUniformLocation(program, "yDistance"), layout.yDistance);
+        glUniform2fv(glGetUniformLocation(program, "corners"), hexGrid::CornerCount, &layout.corners[0].x);
+        glUniform1f(glGetUniformLocation(program, "screenHeight"), layout.screenHeight);
+        glUniform1ui(glGetUniformLocation(program, "seed"), seed);
+        bindPaletteBlock(program);
+        bindFrameBlock(program);
+    });
+
+    return scene;
+}
+
+void ProceduralScene::createVertexArrays() {
+    // core profile still wants a vertex array bound, even without attributes
+    glGenVertexArrays(1, &emptyVAO);
+}
+
+ProceduralScene::~ProceduralScene() {
+    glState::deleteVertexArray(emptyVAO);
+}
+
+void ProceduralScene::reseed(std::uint32_t seed) {
+    programs->forEachProgram([&](GLuint program) {
+        glState::useProgram(program);
+        glUniform1ui(glGetUniformLocation(program, "seed"), seed);
+    });
+}
+
+void ProceduralScene::drawFills(const FrameState& frame) {
+    programs->use(frame);
+
+    glState::bindVertexArray(emptyVAO);
+    glDrawArrays(GL_TRIANGLES, 0, 3);
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstdint>
+
+#include "hexScene.h"
+
+// No geometry at all: a single full-screen triangle whose fragment shader finds
+// the hexagon cell, the cube face and the nearest outline analytically, and
+// decides fills from a hash of the cell and the seed.
+// Fills and edges come out of that one pass, so drawEdges has nothing left to do.
+class ProceduralScene : public HexScene {
+public:
+    static std::unique_ptr<ProceduralScene> create(const Settings& settings, const hexGrid::Layout& layout, std::uint32_t seed);
+    ~ProceduralScene() override;
+
+    void createVertexArrays() override;
+
+    void drawFills(const FrameState& frame) override;
+    void drawEdges(const FrameState& frame) override {}
+    void drawEdgeCoverage(const FrameState& frame) override {}
+    bool cacheableFills() const override { return false; }
+    bool edgesInFillPass() const override { return true; }
+
+    // a new seed reshuffles the holes on the next frame, nothing is rebuilt
+    void reseed(std::uint32_t seed);
+
+private:
+    explicit ProceduralScene(const Settings& settings) : settings(settings) {}
+
+    const Settings& settings;
+
+    std::unique_ptr<EdgePrograms> programs;
+
+    GLuint emptyVAO = 0;
+};
@@ -0,0 +1,170 @@
+#include "sceneBuilder.h"
+
+#include <iostream>
+#include <random>
+#include <utility>
+
+
+std::unique_ptr<SceneBuilder> SceneBuilder::create(GLFWwindow* window, const Settings& settings, const hexGrid::Layout& layout) {
+    std::unique_ptr<SceneBuilder> builder(new SceneBuilder(settings, layout));
+    builder->window = window;
+    builder->worker = std::thread(&SceneBuilder::run, builder.get());
+    return builder;
+}
+
+SceneBuilder::~SceneBuilder() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        quit = true;
+    }
+    wake.notify_one();
+    if (worker.joinable()) {
+        worker.join();
+    }
+
+    // the objects are shared, the draw thread's context can delete them
+    built.reset();
+    if (fence) {
+        glDeleteSync(fence);
+    }
+    if (context) {
+        glfwDestroyWindow(context);
+    }
+}
+
+void SceneBuilder::roll(std::uint32_t seed) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        pendingSeed = seed;
+    }
+    wake.notify_one();
+}
+
+std::optional<HexFills> SceneBuilder::takeFills() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return std::exchange(rolled, std::nullopt);
+}
+
+bool SceneBuilder::build(HexFills fills) {
+    // the worker only reads context once a build is pending, after this
+    if (!context) {
+        // never shown, it only exists for its context, which has to be of the same kind as window's
+        glfwDefaultWindowHints();
+        if (settings.openGLES) {
+            glfwWindowHint(GLFW_CLIENT_API, GLFW_OPENGL_ES_API);
+            glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_EGL_CONTEXT_API);
+            glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+            glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 0);
+        } else {
+            glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+            glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+            glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+        }
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+        context = glfwCreateWindow(1, 1, "", nullptr, window);
+        if (!context) {
+            std::cerr << "Failed to create the shared context, the scene can't be rebuilt in the background" << std::endl;
+            return false;
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        pendingBuild = std::move(fills);
+    }
+    wake.notify_one();
+    return true;
+}
+
+std::unique_ptr<HexScene> SceneBuilder::takeScene() {
+    std::unique_ptr<HexScene> scene;
+    GLsync uploaded = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!built) {
+            return nullptr;
+        }
+        // the worker waited for it already, this only orders the draw thread's context after the uploads
+        GLenum status = glClientWaitSync(fence, 0, 0);
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) {
+            return nullptr;
+        }
+        scene = std::move(built);
+        uploaded = fence;
+        fence = nullptr;
+    }
+    glDeleteSync(uploaded);
+
+    scene->createVertexArrays();
+    return scene;
+}
+
+void SceneBuilder::run() {
+    bool contextCurrent = false;
+
+    while (true) {
+        std::optional<std::uint32_t> seed;
+        std::optional<HexFills> fills;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [this] { return quit || pendingSeed || pendingBuild; });
+            if (quit) {
+                break;
+            }
+            // a roll first, the draw thread may be waiting for it to refill in place
+            if (pendingSeed) {
+                seed = std::exchange(pendingSeed, std::nullopt);
+            } else {
+                fills = std::exchange(pendingBuild, std::nullopt);
+            }
+        }
+
+        // ---------- roll ----------
+        if (seed) {
+            std::mt19937 rng(*seed);
+            HexFills pattern = rollFills(settings, layout, rng);
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                rolled = std::move(pattern);
+            }
+            // an idle draw loop waits for events, this is one
+            glfwPostEmptyEvent();
+            continue;
+        }
+
+        // ---------- build ----------
+        if (!contextCurrent) {
+            glfwMakeContextCurrent(context);
+            contextCurrent = true;
+        }
+
+        std::unique_ptr<HexScene> scene = buildHexScene(settings, layout, *fills);
+        if (!scene) {
+            std::cerr << "Failed to rebuild the scene, keeping the current one" << std::endl;
+            continue;
+        }
+
+        // the flush puts the fence where the draw thread's context can see it, the wait
+        // keeps the handover off the frames still drawing the current scene
+        GLsync uploaded = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+        while (glClientWaitSync(uploaded, flags, 1000000) == GL_TIMEOUT_EXPIRED) {
+            flags = 0;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            // a scene nobody took yet is outdated by this one
+            if (fence) {
+                glDeleteSync(fence);
+            }
+            built = std::move(scene);
+            fence = uploaded;
+        }
+        glfwPostEmptyEvent();
+    }
+
+    if (contextCurrent) {
+        glfwMakeContextCurrent(nullptr);
+    }
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <glad/glad.h>
+#include <GLFW/glfw3.h>
+
+#include "settings.h"
+#include "hexGrid.h"
+#include "hexScene.h"
+
+// Shuffles patterns while the current scene keeps drawing. A worker thread rolls the
+// new fills from a seed, and when the scene can't take them in place it builds a new
+// one as well: on a context of its own, sharing objects with the window's, it builds
+// the geometry, compiles the programs and uploads the buffers. A fence behind the
+// uploads hands the scene over, and the draw thread only takes it once the GPU is done
+// with them, so swapping it in between two frames costs no more than creating its
+// vertex arrays. The context is only created by the first build.
+class SceneBuilder {
+public:
+    // starts the worker, window is the one that draws.
+    // Every pattern is rolled for layout, the screen is measured once at startup
+    static std::unique_ptr<SceneBuilder> create(GLFWwindow* window, const Settings& settings, const hexGrid::Layout& layout);
+    ~SceneBuilder();
+
+    SceneBuilder(const SceneBuilder&) = delete;
+    SceneBuilder& operator=(const SceneBuilder&) = delete;
+
+    // starts rolling a pattern from seed, replacing any roll that hasn't started yet
+    void roll(std::uint32_t seed);
+
+    // the rolled fills, nothing while none are ready. Call on the draw thread
+    std::optional<HexFills> takeFills();
+
+    // starts building a scene with the holes of fills. A request made while one is
+    // being built replaces any other waiting one and is built after it. Call on the
+    // thread that created window, the first call creates the worker's context there.
+    // Returns false when that fails
+    bool build(HexFills fills);
+
+    // the finished scene with its vertex arrays created, nullptr while nothing is ready.
+    // Call on the draw thread, between frames
+    std::unique_ptr<HexScene> takeScene();
+
+private:
+    SceneBuilder(const Settings& settings, const hexGrid::Layout& layout) : settings(settings), layout(layout) {}
+
+    void run();
+
+    const Settings& settings;
+    const hexGrid::Layout layout;
+
+    GLFWwindow* window = nullptr;  // draws, wakes up when fills or a scene are ready
+    GLFWwindow* context = nullptr; // hidden, current on the worker only
+    std::thread worker;
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool quit = false;
+    std::optional<std::uint32_t> pendingSeed;
+    std::optional<HexFills> pendingBuild;
+    std::optional<HexFills> rolled;  // waiting to be taken
+    std::unique_ptr<HexScene> built; // waiting to be taken
+    GLsync fence = nullptr;          // signaled once the uploads of built are complete
+};
@@ -0,0 +1,55 @@
+#include "scenePasses.h"
+
+#include <algorithm>
+#include <memory>
+
+
+// ---------- FillPass ----------
+void FillPass::execute(const FrameState& frame) {
+    if (layerCache) {
+        layerCache->drawFills(scene, frame);
+    } else {
+        scene.drawFills(frame);
+    }
+}
+
+
+// ---------- EdgePass ----------
+EdgePass::EdgePass(const Settings& settings, const hexGrid::Layout& layout, HexScene& scene, LayerCache* layerCache, int width, int height)
+    : scene(scene), layerCache(layerCache), alwaysVisible(settings.barrier.reverse), width(width), height(height) {
+    // the same bounds the damage tracker repaints
+    EdgeReach reach = edgeReach(settings, layout);
+    cursorReach = reach.cursor;
+    waveReach = reach.wave;
+}
+
+bool EdgePass::contributes(const FrameState& frame) const {
+    if (scene.edgesInFillPass()) {
+        return false;
+    }
+    if (alwaysVisible) {
+        return true;
+    }
+
+    if (frame.waveProgress >= 0.0f && frame.waveX + waveReach > 0.0f && frame.waveX - waveReach < width) {
+        return true;
+    }
+
+    float dx = frame.mousePos.x - std::clamp(frame.mousePos.x, 0.0f, static_cast<float>(width));
+    float dy = frame.mousePos.y - std::clamp(frame.mousePos.y, 0.0f, static_cast<float>(height));
+    return dx * dx + dy * dy < cursorReach * cursorReach;
+}
+
+void EdgePass::execute(const FrameState& frame) {
+    if (layerCache) {
+        layerCache->drawEdges(scene, frame);
+    } else {
+        scene.drawEdges(frame);
+    }
+}
+
+
+void addScenePasses(PassList& passes, const Settings& settings, const hexGrid::Layout& layout, HexScene& scene, LayerCache* layerCache, int width, int height) {
+    passes.addPass(std::make_unique<FillPass>(scene, layerCache));
+    passes.addPass(std::make_unique<EdgePass>(settings, layout, scene, layerCache, width, height));
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "settings.h"
+#include "hexGrid.h"
+#include "hexScene.h"
+#include "layerCache.h"
+#include "passList.h"
+
+// the hexagon fills over the cleared background, from the layer cache when there is one
+class FillPass : public RenderPass {
+public:
+    FillPass(HexScene& scene, LayerCache* layerCache) : scene(scene), layerCache(layerCache) {}
+
+    void execute(const FrameState& frame) override;
+
+private:
+    HexScene& scene;
+    LayerCache* layerCache;
+};
+
+// The edges on top of the fills. Outside reverse mode an edge only shows near the cursor
+// or under the wave, so the pass is skipped while neither reaches the screen. Scenes that
+// draw their edges in the fill pass never need it.
+class EdgePass : public RenderPass {
+public:
+    EdgePass(const Settings& settings, const hexGrid::Layout& layout, HexScene& scene, LayerCache* layerCache, int width, int height);
+
+    bool contributes(const FrameState& frame) const override;
+    void execute(const FrameState& frame) override;
+
+private:
+    HexScene& scene;
+    LayerCache* layerCache;
+    bool alwaysVisible; // reverse mode, edges show everywhere but around the cursor
+    int width;
+    int height;
+    float cursorReach; // how far from the cursor an edge pixel can be drawn
+    float waveReach;   // how far from the wave center an edge pixel can be drawn
+};
+
+// adds the passes that draw scene to the screen: the fills, then the edges
+void addScenePasses(PassList& passes, const Settings& settings, const hexGrid::Layout& layout, HexScene& scene, LayerCache* layerCache, int width, int height);
@@ -1,8 +1,68 @@
 #include "settings.h"
 #include <fstream>
 #include <nlohmann/json.hpp>
+#include <iostream>
+#include <algorithm>
+#include <charconv>
 
 
+static RenderMode parseRenderMode(const std::string& name) {
+	if (name == "baked") return RenderMode::Baked;
+	if (name == "instanced") return RenderMode::Instanced;
+	if (name == "procedural") return RenderMode::Procedural;
+
+	std::cerr << "Unknown render-mode \"" << name << "\", falling back to \"baked\"" << std::endl;
+	return RenderMode::Baked;
+}
+
+static Backend parseBackend(const std::string& name) {
+	if (name == "opengl") return Backend::OpenGL;
+	if (name == "vulkan") return Backend::Vulkan;
+
+	std::cerr << "Unknown backend \"" << name << "\", falling back to \"opengl\"" << std::endl;
+	return Backend::OpenGL;
+}
+
+// "HH:MM" or "HH:MM:SS" to seconds after midnight
+static float parseTimeOfDay(const std::string& text) {
+	int parts[3] = { 0, 0, 0 }; // hours, minutes, seconds
+	int count = 0;
+	const char* at = text.data();
+	const char* end = text.data() + text.size();
+	while (count < 3) {
+		auto [next, error] = std::from_chars(at, end, parts[count]);
+		if (error != std::errc()) {
+			break;
+		}
+		count++;
+		if (next == end || *next != ':') {
+			break;
+		}
+		at = next + 1;
+	}
+	if (count < 2) {
+		std::cerr << "Invalid palette start time \"" << text << "\", using 00:00" << std::endl;
+		return 0.0f;
+	}
+	return static_cast<float>(((parts[0] % 24) * 60 + parts[1]) * 60 + parts[2]);
+}
+
+// a scheduled palette, every color it leaves out is taken from the base palette
+static Settings::Palette parsePalette(const nlohmann::json& j, const Settings::Palette& base) {
+	Settings::Palette palette = base;
+	palette.start = parseTimeOfDay(j.value("start", "00:00"));
+	palette.backgroundColor = j.value("background-color", base.backgroundColor);
+	if (j.contains("cube")) {
+		palette.cube.topColor = j["cube"].value("top-color", base.cube.topColor);
+		palette.cube.leftColor = j["cube"].value("left-color", base.cube.leftColor);
+		palette.cube.rightColor = j["cube"].value("right-color", base.cube.rightColor);
+	}
+	if (j.contains("edges")) {
+		palette.edgeColor = j["edges"].value("color", base.edgeColor);
+	}
+	return palette;
+}
+
 Settings loadSettings(const std::string& filename) {
 	std::ifstream file(filename);
 	nlohmann::json j;
@@ -17,6 +77,18 @@ Settings loadSettings(const std::string& filename) {
 
 	settings.hexagonSize = j["hexagon-size"];
 
+	// optional, older settings files don't have it
+	settings.renderMode = parseRenderMode(j.value("render-mode", "baked"));
+	settings.seed = j.value("seed", 0u);
+	settings.layerCache = j.value("layer-cache", false);
+	settings.partialRedraw = j.value("partial-redraw", false);
+	settings.singlePass = j.value("single-pass", false);
+	settings.indirectDraw = j.value("indirect-draw", false);
+	settings.programCache = j.value("program-cache", true);
+	settings.openGLES = j.value("opengl-es", false);
+	settings.backend = parseBackend(j.value("backend", "opengl"));
+	settings.shaderDirectory = j.value("shader-directory", "");
+
 	settings.cube.topColor = j["cube"]["top-color"].get<Color>();
 	settings.cube.leftColor = j["cube"]["left-color"].get<Color>();
 	settings.cube.rightColor = j["cube"]["right-color"].get<Color>();
@@ -33,6 +105,23 @@ Settings loadSettings(const std::string& filename) {
 	settings.wave.interval = j["wave"]["interval"];
 	settings.wave.color = j["wave"]["color"].get<Color>();
 
+	// optional palette schedule, without it the colors above are used all day
+	Settings::Palette basePalette{ 0.0f, settings.backgroundColor, settings.cube, settings.edges.color };
+	settings.palettes = { basePalette };
+	settings.paletteFade = 0.0f;
+	if (j.contains("palette-schedule")) {
+		const nlohmann::json& schedule = j["palette-schedule"];
+		settings.paletteFade = schedule.value("fade", 0.0f);
+		if (schedule.contains("palettes") && !schedule["palettes"].empty()) {
+			settings.palettes.clear();
+			for (const nlohmann::json& entry : schedule["palettes"]) {
+				settings.palettes.push_back(parsePalette(entry, basePalette));
+			}
+			std::sort(settings.palettes.begin(), settings.palettes.end(),
+				[](const Settings::Palette& a, const Settings::Palette& b) { return a.start < b.start; });
+		}
+	}
+
 	settings.MSAA = j["MSAA"];
 
 	return settings;
@@ -3,9 +3,23 @@
 #include <string>
 #include <vector>
 #include <array>
+#include <cstdint>
 
 using Color = std::array<float, 4>;
 
+// how the hexagon geometry is fed to the GPU
+enum class RenderMode {
+	Baked,      // every triangle and edge quad expanded on the CPU
+	Instanced,  // one instance record per hexagon, expanded in the vertex shader
+	Procedural, // no geometry, one full-screen pass computes the cells analytically
+};
+
+// the API the wallpaper is drawn with
+enum class Backend {
+	OpenGL, // every render mode, on desktop GL or OpenGL ES
+	Vulkan, // the procedural mode only, see VulkanRenderer
+};
+
 // settings structure
 struct Settings {
 	float targetFPS;
@@ -15,6 +29,26 @@ struct Settings {
 
 	float hexagonSize;
 
+	RenderMode renderMode;
+
+	std::uint32_t seed; // 0 picks a new random layout on every start
+
+	bool layerCache; // render the static layers once and composite them every frame
+
+	bool partialRedraw; // redraw only the regions the cursor and the wave changed
+
+	bool singlePass; // draw the outlines inside the fill pass instead of a separate edge pass
+
+	bool indirectDraw; // GL 4.5: one geometry buffer built with direct state access, drawn from a command buffer
+
+	bool programCache; // keep linked shader programs on disk so later starts skip compiling
+
+	bool openGLES; // an OpenGL ES 3.0 context through EGL instead of desktop GL 3.3
+
+	Backend backend;
+
+	std::string shaderDirectory; // read shaders from here before the embedded ones, for development
+
 	struct Cube {
 		Color topColor;
 		Color leftColor;
@@ -39,6 +73,18 @@ struct Settings {
 		Color color;
 	} wave;
 
+	// Time-of-day palettes. Without "palette-schedule" there is one, built from the
+	// colors above and starting at midnight. A schedule replaces it with its own
+	// entries, which take the colors they leave out from the ones above
+	struct Palette {
+		float start; // seconds after midnight
+		Color backgroundColor;
+		Cube cube;
+		Color edgeColor;
+	};
+	std::vector<Palette> palettes; // sorted by start, never empty
+	float paletteFade;             // crossfade duration in seconds
+
 	int MSAA;
 };
 
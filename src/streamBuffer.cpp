@@ -0,0 +1,103 @@
+#include "streamBuffer.h"
+#include "modernGL.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+
+std::unique_ptr<StreamBuffer> StreamBuffer::create(GLenum target, GLsizeiptr regionSize, int regionCount) {
+    std::unique_ptr<StreamBuffer> stream(new StreamBuffer(target, regionSize, std::clamp(regionCount, 1, maxRegions)));
+
+    if (target == GL_UNIFORM_BUFFER) {
+        GLint uniformAlignment = 0;
+        glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uniformAlignment);
+        stream->alignment = std::max<GLintptr>(uniformAlignment, stream->alignment);
+    }
+    stream->regionSize = (regionSize + stream->alignment - 1) / stream->alignment * stream->alignment;
+
+    if (modernGL::bufferStorageAvailable()) {
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        const GLsizeiptr size = stream->regionSize * stream->regionCount;
+
+        glGenBuffers(1, &stream->buffer);
+        glBindBuffer(target, stream->buffer);
+        modernGL::bufferStorage(target, size, nullptr, flags);
+        stream->mapped = static_cast<unsigned char*>(glMapBufferRange(target, 0, size, flags));
+        glBindBuffer(target, 0);
+
+        if (stream->mapped) {
+            return stream;
+        }
+        // the storage is immutable, orphaning needs a buffer of its own
+        std::cerr << "Failed to map the stream buffer, orphaning it every frame instead" << std::endl;
+        glDeleteBuffers(1, &stream->buffer);
+    }
+
+    stream->regionCount = 1;
+    glGenBuffers(1, &stream->buffer);
+    glBindBuffer(target, stream->buffer);
+    glBufferData(target, stream->regionSize, nullptr, GL_STREAM_DRAW);
+    glBindBuffer(target, 0);
+    return stream;
+}
+
+StreamBuffer::~StreamBuffer() {
+    for (GLsync fence : fences) {
+        if (fence) {
+            glDeleteSync(fence);
+        }
+    }
+    if (mapped) {
+        glBindBuffer(target, buffer);
+        glUnmapBuffer(target);
+        glBindBuffer(target, 0);
+    }
+    glDeleteBuffers(1, &buffer);
+}
+
+void StreamBuffer::beginFrame() {
+    head = 0;
+
+    if (!mapped) {
+        // orphaned: whatever still reads the old storage keeps it, the writes get new storage
+        glBindBuffer(target, buffer);
+        glBufferData(target, regionSize, nullptr, GL_STREAM_DRAW);
+        glBindBuffer(target, 0);
+        return;
+    }
+
+    fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    region = (region + 1) % regionCount;
+
+    GLsync& fence = fences[region];
+    if (fence) {
+        // with a few regions in flight this rarely waits, and when it does the GPU is the bottleneck anyway
+        GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+        while (glClientWaitSync(fence, flags, 1000000) == GL_TIMEOUT_EXPIRED) {
+            flags = 0;
+        }
+        glDeleteSync(fence);
+        fence = nullptr;
+    }
+}
+
+StreamBuffer::Allocation StreamBuffer::write(const void* data, GLsizeiptr size) {
+    const GLintptr start = (head + alignment - 1) / alignment * alignment;
+    if (start + size > regionSize) {
+        std::cerr << "Stream buffer region full, dropping a write of " << size << " bytes" << std::endl;
+        return {};
+    }
+    head = start + size;
+
+    const GLintptr offset = region * regionSize + start;
+    if (mapped) {
+        // coherent, visible to the next command without a flush
+        std::memcpy(mapped + offset, data, static_cast<size_t>(size));
+    } else {
+        glBindBuffer(target, buffer);
+        glBufferSubData(target, offset, size, data);
+        glBindBuffer(target, 0);
+    }
+    return { buffer, offset, size };
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <array>
+#include <memory>
+#include <glad/glad.h>
+
+// Data the CPU rewrites every frame (uniform blocks today, more effects later), streamed
+// through one buffer split into a region per frame in flight.
+// With ARB_buffer_storage the buffer stays mapped persistent and coherent: writes land
+// in memory the GPU reads directly, and a fence per region keeps the CPU from
+// overwriting a region an earlier frame may still be drawing from. Without it every
+// frame orphans the buffer with glBufferData, the driver hands out fresh storage
+// instead of waiting for the GPU, and writes go through glBufferSubData.
+// A write stays intact until the stream comes back around to its region, so a client
+// that only writes when its data changed needs a stream of its own.
+class StreamBuffer {
+public:
+    static constexpr int maxRegions = 4;
+
+    // regionSize bytes are available to the writes of every frame. Falls back to
+    // orphaning when the buffer can't be mapped
+    static std::unique_ptr<StreamBuffer> create(GLenum target, GLsizeiptr regionSize, int regionCount = 3);
+    ~StreamBuffer();
+
+    StreamBuffer(const StreamBuffer&) = delete;
+    StreamBuffer& operator=(const StreamBuffer&) = delete;
+
+    struct Allocation {
+        GLuint buffer = 0;
+        GLintptr offset = 0;
+        GLsizeiptr size = 0; // 0 when the region was full
+    };
+
+    // fences the region of the last frame, everything reading from it has been issued by
+    // now, and moves on to the next one, waiting for the GPU to be done with it first
+    void beginFrame();
+
+    // copies size bytes into the region of the frame, at an offset the target can bind
+    Allocation write(const void* data, GLsizeiptr size);
+
+    bool persistent() const { return mapped != nullptr; }
+
+private:
+    StreamBuffer(GLenum target, GLsizeiptr regionSize, int regionCount)
+        : target(target), regionSize(regionSize), regionCount(regionCount) {}
+
+    GLenum target;
+    GLsizeiptr regionSize; // a multiple of the alignment
+    int regionCount;       // 1 when orphaning
+    GLintptr alignment = 4;
+
+    GLuint buffer = 0;
+    unsigned char* mapped = nullptr; // the whole buffer, null when orphaning
+
+    int region = 0;
+    GLintptr head = 0; // next free byte of the region
+    std::array<GLsync, maxRegions> fences{};
+};
@@ -1,73 +1,419 @@
 #include "utils.h"
+#include "embeddedShaders.h"
+#include "glState.h"
+#include "gles.h"
 
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <vector>
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <initializer_list>
+#include <thread>
 
-static std::string readShaderFile(const std::string& filePath) {
-    std::ifstream shaderFile;
-    shaderFile.exceptions(std::ifstream::failbit | std::ifstream::badbit);
-    try {
-        shaderFile.open(filePath);
-        std::stringstream shaderStream;
-        shaderStream << shaderFile.rdbuf();
-        shaderFile.close();
-        return shaderStream.str();
-    } catch (std::ifstream::failure) {
-        std::cerr << "ERROR::SHADER::FILE_NOT_SUCCESSFULLY_READ: " << filePath << std::endl;
+// defines of the features, in bit order
+static const char* const featureDefines[] = { "REVERSE_MODE", "WAVE_ACTIVE", "ANALYTIC_AA" };
+
+// includes nested deeper than this are reported as a cycle
+static constexpr int maxIncludeDepth = 16;
+
+// development copies of the shaders, empty when only the embedded ones are used
+static std::filesystem::path shaderDirectory;
+
+void shaderUtils::setShaderDirectory(const std::string& directory) {
+    shaderDirectory = directory;
+}
+
+// the override from the shader directory, or else the copy built into the executable
+static std::string readShaderFile(const std::string& name) {
+    if (!shaderDirectory.empty()) {
+        std::ifstream shaderFile(shaderDirectory / name, std::ios::binary);
+        if (shaderFile) {
+            std::stringstream shaderStream;
+            shaderStream << shaderFile.rdbuf();
+            return shaderStream.str();
+        }
+    }
+
+    for (const EmbeddedShader& shader : embeddedShaders()) {
+        if (shader.name == name) {
+            return std::string(shader.source);
+        }
+    }
+
+    std::cerr << "ERROR::SHADER::FILE_NOT_FOUND: " << name << std::endl;
+    return "";
+}
+
+// Appends the file to out with its includes expanded. Every file gets its own
+// source string number in #line directives, files lists them in that order.
+static bool preprocess(const std::string& path, std::uint32_t features, int depth,
+                       std::vector<std::string>& files, std::ostringstream& out) {
+    if (depth > maxIncludeDepth) {
+        std::cerr << "ERROR::SHADER::INCLUDE_TOO_DEEP: " << path << std::endl;
+        return false;
+    }
+
+    std::string source = readShaderFile(path);
+    if (source.empty()) {
+        return false;
+    }
+
+    const int fileIndex = static_cast<int>(files.size());
+    files.push_back(path);
+    const std::string directory = path.substr(0, path.find_last_of("/\\") + 1);
+
+    std::istringstream lines(source);
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(lines, line)) {
+        lineNumber++;
+        size_t start = line.find_first_not_of(" \t");
+        std::string directive = start == std::string::npos ? "" : line.substr(start);
+
+        if (directive.rfind("#include", 0) == 0) {
+            size_t open = directive.find('"');
+            size_t close = directive.find('"', open + 1);
+            if (open == std::string::npos || close == std::string::npos) {
+                std::cerr << "ERROR::SHADER::BAD_INCLUDE: " << path << ":" << lineNumber << std::endl;
+                return false;
+            }
+
+            std::string includePath = directory + directive.substr(open + 1, close - open - 1);
+            if (std::find(files.begin(), files.end(), includePath) == files.end()) {
+                out << "#line 1 " << files.size() << "\n";
+                if (!preprocess(includePath, features, depth + 1, files, out)) {
+                    return false;
+                }
+            }
+            out << "#line " << lineNumber + 1 << " " << fileIndex << "\n";
+            continue;
+        }
+
+        const bool version = depth == 0 && directive.rfind("#version", 0) == 0;
+        if (version && gles::active()) {
+            // GLSL 3.30 and GLSL ES 3.00 are close enough to share the sources
+            out << "#version 300 es\n";
+        } else {
+            out << line << "\n";
+        }
+
+        // the defines have to come right after the version
+        if (version) {
+            for (size_t i = 0; i < std::size(featureDefines); i++) {
+                if (features & (1u << i)) {
+                    out << "#define " << featureDefines[i] << "\n";
+                }
+            }
+            // positions are in pixels of large screens and stay highp, the shaders mark
+            // what is safe at mediump. Layers are 8 bits per channel
+            if (gles::active()) {
+                out << "precision highp float;\nprecision highp int;\nprecision mediump sampler2D;\n";
+            }
+            out << "#line " << lineNumber + 1 << " " << fileIndex << "\n";
+        }
+    }
+    return true;
+}
+
+// preprocesses the stage at path, files gets the source string numbers for error messages
+static std::string stageSource(const std::string& path, std::uint32_t features, std::vector<std::string>& files) {
+    std::ostringstream code;
+    if (!preprocess(path, features, 0, files, code)) {
         return "";
     }
+    return code.str();
 }
 
-GLuint shaderUtils::compileShaders(const std::string& vertexPath, const std::string& fragmentPath) {
-    // 1. Read shader sources
-    std::string vertexCode = readShaderFile(vertexPath);
-    std::string fragmentCode = readShaderFile(fragmentPath);
-    const char* vShaderCode = vertexCode.c_str();
-    const char* fShaderCode = fragmentCode.c_str();
+// GL 4.3 / ARB_compute_shader, not part of the 3.3 loader
+#define GL_COMPUTE_SHADER 0x91B9
+
+static GLuint compileStage(GLenum type, const std::string& source, const std::vector<std::string>& files) {
+    const char* stageName = type == GL_VERTEX_SHADER ? "VERTEX" : type == GL_COMPUTE_SHADER ? "COMPUTE" : "FRAGMENT";
+    const char* sourceCode = source.c_str();
+
+    GLuint shader = glCreateShader(type);
+    glShaderSource(shader, 1, &sourceCode, nullptr);
+    glCompileShader(shader);
 
-    // 2. Compile vertex shader
-    GLuint vertex = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertex, 1, &vShaderCode, nullptr);
-    glShaderSource(vertex, 1, &vShaderCode, nullptr);
-    glCompileShader(vertex);
-    // Check for errors
     GLint success;
-    glGetShaderiv(vertex, GL_COMPILE_STATUS, &success);
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
     if (!success) {
-        char infoLog[512];
-        glGetShaderInfoLog(vertex, 512, nullptr, infoLog);
-        std::cerr << "ERROR::SHADER::VERTEX::COMPILATION_FAILED\n" << infoLog << std::endl;
+        char infoLog[1024];
+        glGetShaderInfoLog(shader, sizeof(infoLog), nullptr, infoLog);
+        std::cerr << "ERROR::SHADER::" << stageName << "::COMPILATION_FAILED\n" << infoLog;
+        // errors are reported as source string:line
+        for (size_t i = 0; i < files.size(); i++) {
+            std::cerr << "  source " << i << ": " << files[i] << "\n";
+        }
+        std::cerr << std::endl;
+        glDeleteShader(shader);
+        return 0;
     }
+    return shader;
+}
 
-    // 3. Compile fragment shader
-    GLuint fragment = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragment, 1, &fShaderCode, nullptr);
-    glCompileShader(fragment);
-    // Check for errors
-    glGetShaderiv(fragment, GL_COMPILE_STATUS, &success);
-    if (!success) {
-        char infoLog[512];
-        glGetShaderInfoLog(fragment, 512, nullptr, infoLog);
-        std::cerr << "ERROR::SHADER::FRAGMENT::COMPILATION_FAILED\n" << infoLog << std::endl;
+
+// ---------- program binary cache ----------
+// GL 4.1 / ARB_get_program_binary, not part of the 3.3 loader
+#define GL_PROGRAM_BINARY_RETRIEVABLE_HINT 0x8257
+#define GL_PROGRAM_BINARY_LENGTH           0x8741
+#define GL_NUM_PROGRAM_BINARY_FORMATS      0x87FE
+
+typedef void (APIENTRYP PFNGLGETPROGRAMBINARYPROC)(GLuint program, GLsizei bufSize, GLsizei* length, GLenum* binaryFormat, void* binary);
+typedef void (APIENTRYP PFNGLPROGRAMBINARYPROC)(GLuint program, GLenum binaryFormat, const void* binary, GLsizei length);
+typedef void (APIENTRYP PFNGLPROGRAMPARAMETERIPROC)(GLuint program, GLenum pname, GLint value);
+
+namespace {
+    struct ProgramCache {
+        bool enabled = false;
+        std::filesystem::path directory;
+        std::string driver; // vendor, renderer and version, a driver update invalidates every entry
+
+        PFNGLGETPROGRAMBINARYPROC getProgramBinary = nullptr;
+        PFNGLPROGRAMBINARYPROC programBinary = nullptr;
+        PFNGLPROGRAMPARAMETERIPROC programParameteri = nullptr;
+    };
+
+    ProgramCache programCache;
+
+    // written in front of every binary, so foreign or truncated files are never handed to the driver
+    struct BinaryHeader {
+        char magic[4];
+        std::uint32_t format;
+        std::uint32_t length;
+    };
+    constexpr char binaryMagic[4] = { 'S', 'F', 'P', 'B' };
+}
+
+// 64 bit FNV-1a
+static std::uint64_t hashString(const std::string& text, std::uint64_t hash = 0xcbf29ce484222325ull) {
+    for (unsigned char c : text) {
+        hash ^= c;
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+static std::filesystem::path cachePath(const std::string& vertexSource, const std::string& fragmentSource) {
+    // the separators keep moving text between the parts from giving the same hash
+    std::uint64_t hash = hashString(programCache.driver);
+    hash = hashString(std::string(1, '\0') + vertexSource, hash);
+    hash = hashString(std::string(1, '\0') + fragmentSource, hash);
+
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.bin", static_cast<unsigned long long>(hash));
+    return programCache.directory / name;
+}
+
+// the cached program, or 0 when there is none or the driver rejects it
+static GLuint loadCachedProgram(const std::filesystem::path& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return 0;
+    }
+
+    BinaryHeader header{};
+    std::vector<char> binary;
+    if (file.read(reinterpret_cast<char*>(&header), sizeof(header)) &&
+        std::equal(std::begin(binaryMagic), std::end(binaryMagic), header.magic)) {
+        binary.resize(header.length);
+        file.read(binary.data(), binary.size());
+    }
+    bool complete = !binary.empty() && file.gcount() == static_cast<std::streamsize>(binary.size());
+    file.close();
+
+    GLuint program = 0;
+    if (complete) {
+        program = glCreateProgram();
+        programCache.programBinary(program, header.format, binary.data(), static_cast<GLsizei>(binary.size()));
+
+        GLint success;
+        glGetProgramiv(program, GL_LINK_STATUS, &success);
+        if (!success) {
+            glDeleteProgram(program);
+            program = 0;
+        }
+    }
+
+    if (program == 0) {
+        // stale or damaged, it is replaced by the freshly linked program
+        std::error_code error;
+        std::filesystem::remove(path, error);
+    }
+    return program;
+}
+
+static void storeCachedProgram(const std::filesystem::path& path, GLuint program) {
+    GLint length = 0;
+    glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+    if (length <= 0) {
+        return;
+    }
+
+    BinaryHeader header{};
+    std::copy(std::begin(binaryMagic), std::end(binaryMagic), header.magic);
+    std::vector<char> binary(length);
+    GLsizei written = 0;
+    programCache.getProgramBinary(program, length, &written, &header.format, binary.data());
+    if (written <= 0) {
+        return;
+    }
+    header.length = static_cast<std::uint32_t>(written);
+
+    // written aside and renamed, so a concurrent launch never reads half a file
+    std::error_code error;
+    std::filesystem::create_directories(programCache.directory, error);
+    // one temporary per thread, the scene builder's context links programs next to the draw thread's
+    char suffix[32];
+    std::snprintf(suffix, sizeof(suffix), ".%zx.tmp", std::hash<std::thread::id>{}(std::this_thread::get_id()));
+    std::filesystem::path temporary = path;
+    temporary += suffix;
+    {
+        std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(binary.data(), written);
+        if (!file) {
+            file.close();
+            std::filesystem::remove(temporary, error);
+            return;
+        }
+    }
+    std::filesystem::rename(temporary, path, error);
+    if (error) {
+        std::filesystem::remove(temporary, error);
+    }
+}
+
+void shaderUtils::enableProgramCache(const std::string& directory, GLADloadproc load) {
+    programCache = ProgramCache{};
+
+    GLint formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    programCache.getProgramBinary = reinterpret_cast<PFNGLGETPROGRAMBINARYPROC>(load("glGetProgramBinary"));
+    programCache.programBinary = reinterpret_cast<PFNGLPROGRAMBINARYPROC>(load("glProgramBinary"));
+    programCache.programParameteri = reinterpret_cast<PFNGLPROGRAMPARAMETERIPROC>(load("glProgramParameteri"));
+    glGetError(); // the query fails on drivers without program binaries
+
+    if (formats <= 0 || !programCache.getProgramBinary || !programCache.programBinary || !programCache.programParameteri) {
+        std::cerr << "Program binaries unsupported, shaders are compiled on every start" << std::endl;
+        return;
     }
 
-    // 4. Link shader program
+    auto glString = [](GLenum name) {
+        const GLubyte* value = glGetString(name);
+        return value ? std::string(reinterpret_cast<const char*>(value)) : std::string();
+    };
+    programCache.driver = glString(GL_VENDOR) + "\n" + glString(GL_RENDERER) + "\n" + glString(GL_VERSION);
+    programCache.directory = directory;
+    programCache.enabled = true;
+}
+
+
+// ---------- compiling ----------
+// links the compiled stages, which are deleted afterwards, and caches the result at binaryPath
+static GLuint linkProgram(std::initializer_list<GLuint> stages, const std::filesystem::path& binaryPath) {
     GLuint program = glCreateProgram();
-    glAttachShader(program, vertex);
-    glAttachShader(program, fragment);
+    for (GLuint stage : stages) {
+        glAttachShader(program, stage);
+    }
+    if (programCache.enabled) {
+        programCache.programParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    }
     glLinkProgram(program);
+
+    // Cleanup shaders (they're linked now)
+    for (GLuint stage : stages) {
+        glDeleteShader(stage);
+    }
+
     // Check for linking errors
+    GLint success;
     glGetProgramiv(program, GL_LINK_STATUS, &success);
     if (!success) {
-        char infoLog[512];
-        glGetProgramInfoLog(program, 512, nullptr, infoLog);
+        char infoLog[1024];
+        glGetProgramInfoLog(program, sizeof(infoLog), nullptr, infoLog);
         std::cerr << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
+        glDeleteProgram(program);
+        return 0;
     }
 
-    // 5. Cleanup shaders (they're linked now)
-    glDeleteShader(vertex);
-    glDeleteShader(fragment);
+    if (programCache.enabled) {
+        storeCachedProgram(binaryPath, program);
+    }
+    return program;
+}
+
+GLuint shaderUtils::compileShaders(const std::string& vertexPath, const std::string& fragmentPath, std::uint32_t features) {
+    // 1. Preprocess both stages, the result is what the cache is keyed on
+    std::vector<std::string> vertexFiles, fragmentFiles;
+    std::string vertexSource = stageSource(vertexPath, features, vertexFiles);
+    std::string fragmentSource = stageSource(fragmentPath, features, fragmentFiles);
+    if (vertexSource.empty() || fragmentSource.empty()) {
+        std::cerr << "ERROR::SHADER::PREPROCESSING_FAILED: " << vertexPath << ", " << fragmentPath << std::endl;
+        return 0;
+    }
+
+    std::filesystem::path binaryPath;
+    if (programCache.enabled) {
+        binaryPath = cachePath(vertexSource, fragmentSource);
+        if (GLuint program = loadCachedProgram(binaryPath)) {
+            return program;
+        }
+    }
+
+    // 2. Compile both stages
+    GLuint vertex = compileStage(GL_VERTEX_SHADER, vertexSource, vertexFiles);
+    GLuint fragment = compileStage(GL_FRAGMENT_SHADER, fragmentSource, fragmentFiles);
+    if (vertex == 0 || fragment == 0) {
+        glDeleteShader(vertex);
+        glDeleteShader(fragment);
+        return 0;
+    }
+
+    // 3. Link shader program
+    return linkProgram({ vertex, fragment }, binaryPath);
+}
+
+GLuint shaderUtils::compileComputeShader(const std::string& computePath, std::uint32_t features) {
+    std::vector<std::string> files;
+    std::string source = stageSource(computePath, features, files);
+    if (source.empty()) {
+        std::cerr << "ERROR::SHADER::PREPROCESSING_FAILED: " << computePath << std::endl;
+        return 0;
+    }
+
+    // a single stage, the empty second part keeps it apart from any vertex/fragment pair
+    std::filesystem::path binaryPath;
+    if (programCache.enabled) {
+        binaryPath = cachePath(source, "");
+        if (GLuint program = loadCachedProgram(binaryPath)) {
+            return program;
+        }
+    }
+
+    GLuint compute = compileStage(GL_COMPUTE_SHADER, source, files);
+    if (compute == 0) {
+        return 0;
+    }
+    return linkProgram({ compute }, binaryPath);
+}
+
+shaderUtils::ProgramVariants::~ProgramVariants() {
+    for (const auto& [features, program] : programs) {
+        glState::deleteProgram(program);
+    }
+}
+
+GLuint shaderUtils::ProgramVariants::get(std::uint32_t features) {
+    auto found = programs.find(features);
+    if (found != programs.end()) {
+        return found->second;
+    }
 
+    GLuint program = compileShaders(vertexPath, fragmentPath, features);
+    programs.emplace(features, program);
     return program;
 }
@@ -1,9 +1,56 @@
 #pragma once
 
+#include <cstdint>
 #include <string>
+#include <unordered_map>
 #include <glad/glad.h>
 
 namespace shaderUtils {
-    // compiles glsl shaders
-    GLuint compileShaders(const std::string& vertexPath, const std::string& fragmentPath);
+    // features a program can be specialised for, each one is compiled in as a #define
+    enum Feature : std::uint32_t {
+        FeatureReverse    = 1u << 0, // REVERSE_MODE: edges hide near the cursor instead of showing up
+        FeatureWave       = 1u << 1, // WAVE_ACTIVE: a wave is crossing the screen
+        FeatureAnalyticAA = 1u << 2, // ANALYTIC_AA: edges are smoothed in the shader instead of by multisampling
+    };
+
+    // Shaders are built into the executable. During development they can be read from
+    // directory instead, which holds the same layout as the shaders folder; files it
+    // doesn't have still come from the executable. Empty turns the override off
+    void setShaderDirectory(const std::string& directory);
+
+    // Keeps every linked program as a driver binary in directory, so later starts load it
+    // instead of compiling. Entries are keyed on the preprocessed sources and the driver
+    // identity; a binary the driver rejects is deleted and compiled again. Needs GL 4.1 or
+    // ARB_get_program_binary, whose functions are looked up with load, and changes nothing
+    // without them. Call after the context is current and before any program is compiled
+    void enableProgramCache(const std::string& directory, GLADloadproc load);
+
+    // compiles glsl shaders, named by their path in the shaders folder. Both stages get #include "file" resolved relative to the
+    // including file (every file is included once) and a #define for each feature. On OpenGL ES the version
+    // line becomes GLSL ES 3.00 with default precisions, see gles.h.
+    // Returns 0 if a stage fails to compile or the program fails to link
+    GLuint compileShaders(const std::string& vertexPath, const std::string& fragmentPath, std::uint32_t features = 0);
+
+    // compiles a glsl compute shader the same way, needs GL 4.3 or ARB_compute_shader
+    GLuint compileComputeShader(const std::string& computePath, std::uint32_t features = 0);
+
+    // The compiled variants of one vertex/fragment pair, keyed by their features.
+    // A variant is compiled the first time it is asked for and kept until destruction
+    class ProgramVariants {
+    public:
+        ProgramVariants(const std::string& vertexPath, const std::string& fragmentPath)
+            : vertexPath(vertexPath), fragmentPath(fragmentPath) {}
+        ~ProgramVariants();
+
+        ProgramVariants(const ProgramVariants&) = delete;
+        ProgramVariants& operator=(const ProgramVariants&) = delete;
+
+        // 0 if the variant failed to compile, which is remembered and not retried
+        GLuint get(std::uint32_t features);
+
+    private:
+        std::string vertexPath;
+        std::string fragmentPath;
+        std::unordered_map<std::uint32_t, GLuint> programs;
+    };
 }
@@ -0,0 +1,844 @@
+#include "vulkanRenderer.h"
+#include "embeddedShaders.h"
+#include "utils.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <span>
+#include <string_view>
+
+
+// the "Grid" block of procedural_fragment.glsl, std140: what ProceduralScene sets as loose uniforms
+struct GridBlock {
+    glm::vec4 corners[hexGrid::CornerCount]; // xy, std140 pads every array element to 16 bytes
+    float hexagonWidth;
+    float sliceWidth;
+    float yDistance;
+    float screenHeight;
+    std::uint32_t seed;
+    float padding[3];
+};
+static_assert(sizeof(GridBlock) == 128, "GridBlock must match the std140 layout of the Grid block");
+
+// where the blocks of a frame in flight sit in the uniform buffer. Offsets are aligned
+// for the largest minUniformBufferOffsetAlignment Vulkan allows, 256
+static constexpr VkDeviceSize paletteOffset = 0;
+static constexpr VkDeviceSize gridOffset = 256;
+static constexpr VkDeviceSize frameUniformsSize = 512;
+static_assert(sizeof(PaletteBlock) <= gridOffset && gridOffset + sizeof(GridBlock) <= frameUniformsSize);
+
+// the SPIR-V of name compiled with features, empty when the build has none
+static std::span<const std::uint32_t> findSpirv(std::string_view name, std::uint32_t features) {
+    for (const EmbeddedSpirv& shader : embeddedSpirv()) {
+        if (shader.name == name && shader.features == features) {
+            return shader.code;
+        }
+    }
+    return {};
+}
+
+
+std::unique_ptr<VulkanRenderer> VulkanRenderer::create(const Surface& surface, const Settings& settings,
+                                                       const hexGrid::Layout& layout, int width, int height, std::uint32_t seed) {
+    std::unique_ptr<VulkanRenderer> renderer(new VulkanRenderer(settings, layout));
+    renderer->seed = seed;
+    renderer->extent = { static_cast<std::uint32_t>(width), static_cast<std::uint32_t>(height) };
+
+    if (!renderer->createInstance(surface.instanceExtensions)) {
+        return nullptr;
+    }
+    if (surface.create(renderer->instance, &renderer->surface) != VK_SUCCESS) {
+        std::cerr << "Failed to create the Vulkan surface" << std::endl;
+        return nullptr;
+    }
+    if (!renderer->createDevice() || !renderer->createSwapchain() || !renderer->createPipelines() || !renderer->createFrames()) {
+        return nullptr;
+    }
+    return renderer;
+}
+
+std::unique_ptr<VulkanRenderer> VulkanRenderer::createOffscreen(const Settings& settings, const hexGrid::Layout& layout,
+                                                                int width, int height, std::uint32_t seed) {
+    std::unique_ptr<VulkanRenderer> renderer(new VulkanRenderer(settings, layout));
+    renderer->seed = seed;
+    renderer->extent = { static_cast<std::uint32_t>(width), static_cast<std::uint32_t>(height) };
+
+    if (!renderer->createInstance({}) || !renderer->createDevice() || !renderer->createOffscreenTarget() ||
+        !renderer->createPipelines() || !renderer->createFrames()) {
+        return nullptr;
+    }
+    return renderer;
+}
+
+VulkanRenderer::~VulkanRenderer() {
+    if (device) {
+        vkDeviceWaitIdle(device);
+
+        for (Frame& frame : frames) {
+            vkDestroyFence(device, frame.done, nullptr);
+            vkDestroySemaphore(device, frame.acquired, nullptr);
+        }
+        vkDestroyCommandPool(device, commandPool, nullptr);
+        vkDestroyDescriptorPool(device, descriptorPool, nullptr);
+        vkDestroyBuffer(device, uniforms, nullptr);
+        vkFreeMemory(device, uniformMemory, nullptr);
+
+        vkDestroyPipeline(device, still, nullptr);
+        vkDestroyPipeline(device, wave, nullptr);
+        vkDestroyPipelineLayout(device, pipelineLayout, nullptr);
+        vkDestroyDescriptorSetLayout(device, setLayout, nullptr);
+
+        destroySwapchain();
+        vkDestroyRenderPass(device, renderPass, nullptr);
+        vkDestroyDevice(device, nullptr);
+    }
+    if (instance) {
+        if (surface) {
+            vkDestroySurfaceKHR(instance, surface, nullptr);
+        }
+        vkDestroyInstance(instance, nullptr);
+    }
+}
+
+// ---------- instance and device ----------
+
+bool VulkanRenderer::createInstance(const std::vector<const char*>& extensions) {
+    VkApplicationInfo application{ VK_STRUCTURE_TYPE_APPLICATION_INFO };
+    application.pApplicationName = "ShahrFlow";
+    application.apiVersion = VK_API_VERSION_1_0;
+
+    VkInstanceCreateInfo info{ VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO };
+    info.pApplicationInfo = &application;
+    info.enabledExtensionCount = static_cast<std::uint32_t>(extensions.size());
+    info.ppEnabledExtensionNames = extensions.data();
+    if (vkCreateInstance(&info, nullptr, &instance) != VK_SUCCESS) {
+        instance = VK_NULL_HANDLE;
+        std::cerr << "Failed to create the Vulkan instance" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool VulkanRenderer::createDevice() {
+    std::uint32_t deviceCount = 0;
+    vkEnumeratePhysicalDevices(instance, &deviceCount, nullptr);
+    std::vector<VkPhysicalDevice> devices(deviceCount);
+    vkEnumeratePhysicalDevices(instance, &deviceCount, devices.data());
+
+    // the first device with a queue that draws and, with a surface, presents to it
+    for (VkPhysicalDevice candidate : devices) {
+        std::uint32_t familyCount = 0;
+        vkGetPhysicalDeviceQueueFamilyProperties(candidate, &familyCount, nullptr);
+        std::vector<VkQueueFamilyProperties> families(familyCount);
+        vkGetPhysicalDeviceQueueFamilyProperties(candidate, &familyCount, families.data());
+
+        for (std::uint32_t i = 0; i < familyCount && !physicalDevice; i++) {
+            VkBool32 presents = VK_TRUE;
+            if (surface) {
+                vkGetPhysicalDeviceSurfaceSupportKHR(candidate, i, surface, &presents);
+            }
+            if ((families[i].queueFlags & VK_QUEUE_GRAPHICS_BIT) && presents) {
+                physicalDevice = candidate;
+                queueFamily = i;
+            }
+        }
+        if (physicalDevice) {
+            break;
+        }
+    }
+    if (!physicalDevice) {
+        std::cerr << "Failed to find a Vulkan device that can draw" << (surface ? " to the window" : "") << std::endl;
+        return false;
+    }
+    vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memoryProperties);
+
+    const float priority = 1.0f;
+    VkDeviceQueueCreateInfo queueInfo{ VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO };
+    queueInfo.queueFamilyIndex = queueFamily;
+    queueInfo.queueCount = 1;
+    queueInfo.pQueuePriorities = &priority;
+
+    const char* swapchainExtension = VK_KHR_SWAPCHAIN_EXTENSION_NAME;
+    VkDeviceCreateInfo info{ VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO };
+    info.queueCreateInfoCount = 1;
+    info.pQueueCreateInfos = &queueInfo;
+    if (surface) {
+        info.enabledExtensionCount = 1;
+        info.ppEnabledExtensionNames = &swapchainExtension;
+    }
+    if (vkCreateDevice(physicalDevice, &info, nullptr, &device) != VK_SUCCESS) {
+        device = VK_NULL_HANDLE;
+        std::cerr << "Failed to create the Vulkan device" << std::endl;
+        return false;
+    }
+    vkGetDeviceQueue(device, queueFamily, 0, &queue);
+    return true;
+}
+
+int VulkanRenderer::findMemoryType(std::uint32_t typeBits, VkMemoryPropertyFlags properties) const {
+    for (std::uint32_t i = 0; i < memoryProperties.memoryTypeCount; i++) {
+        if ((typeBits & (1u << i)) && (memoryProperties.memoryTypes[i].propertyFlags & properties) == properties) {
+            return static_cast<int>(i);
+        }
+    }
+    return -1;
+}
+
+// ---------- render targets ----------
+
+// clears the target and leaves it for presenting, or for the copy of readback() offscreen
+static VkRenderPass createRenderPass(VkDevice device, VkFormat format, VkImageLayout finalLayout) {
+    VkAttachmentDescription attachment{};
+    attachment.format = format;
+    attachment.samples = VK_SAMPLE_COUNT_1_BIT;
+    attachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    attachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+    attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    attachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    attachment.finalLayout = finalLayout;
+
+    VkAttachmentReference color{ 0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL };
+    VkSubpassDescription subpass{};
+    subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+    subpass.colorAttachmentCount = 1;
+    subpass.pColorAttachments = &color;
+
+    // the clear waits for the acquire semaphore, or for the last copy out of the offscreen
+    // image; the copy waits for the frame it reads
+    VkSubpassDependency dependencies[2]{};
+    dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
+    dependencies[0].dstSubpass = 0;
+    dependencies[0].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT;
+    dependencies[0].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    dependencies[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    dependencies[1].srcSubpass = 0;
+    dependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
+    dependencies[1].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    dependencies[1].dstStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT;
+    dependencies[1].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    dependencies[1].dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+
+    VkRenderPassCreateInfo info{ VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO };
+    info.attachmentCount = 1;
+    info.pAttachments = &attachment;
+    info.subpassCount = 1;
+    info.pSubpasses = &subpass;
+    info.dependencyCount = 2;
+    info.pDependencies = dependencies;
+
+    VkRenderPass renderPass = VK_NULL_HANDLE;
+    if (vkCreateRenderPass(device, &info, nullptr, &renderPass) != VK_SUCCESS) {
+        return VK_NULL_HANDLE;
+    }
+    return renderPass;
+}
+
+bool VulkanRenderer::createFramebuffer(Target& target) {
+    VkImageViewCreateInfo viewInfo{ VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO };
+    viewInfo.image = target.image;
+    viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    viewInfo.format = format;
+    viewInfo.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+    if (vkCreateImageView(device, &viewInfo, nullptr, &target.view) != VK_SUCCESS) {
+        target.view = VK_NULL_HANDLE;
+        return false;
+    }
+
+    VkFramebufferCreateInfo info{ VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO };
+    info.renderPass = renderPass;
+    info.attachmentCount = 1;
+    info.pAttachments = &target.view;
+    info.width = extent.width;
+    info.height = extent.height;
+    info.layers = 1;
+    if (vkCreateFramebuffer(device, &info, nullptr, &target.framebuffer) != VK_SUCCESS) {
+        target.framebuffer = VK_NULL_HANDLE;
+        return false;
+    }
+    return true;
+}
+
+bool VulkanRenderer::createSwapchain() {
+    VkSurfaceCapabilitiesKHR capabilities{};
+    vkGetPhysicalDeviceSurfaceCapabilitiesKHR(physicalDevice, surface, &capabilities);
+
+    std::uint32_t formatCount = 0;
+    vkGetPhysicalDeviceSurfaceFormatsKHR(physicalDevice, surface, &formatCount, nullptr);
+    std::vector<VkSurfaceFormatKHR> formats(formatCount);
+    vkGetPhysicalDeviceSurfaceFormatsKHR(physicalDevice, surface, &formatCount, formats.data());
+    if (formats.empty()) {
+        std::cerr << "Failed to find a format for the Vulkan surface" << std::endl;
+        return false;
+    }
+
+    // the colors are blended as they are, like on the GL default framebuffer, so no sRGB format
+    VkSurfaceFormatKHR surfaceFormat = formats[0];
+    for (const VkSurfaceFormatKHR& candidate : formats) {
+        if (candidate.format == VK_FORMAT_B8G8R8A8_UNORM || candidate.format == VK_FORMAT_R8G8B8A8_UNORM) {
+            surfaceFormat = candidate;
+            break;
+        }
+    }
+
+    // vsync waits for the display, otherwise the newest frame replaces a queued one
+    // without tearing where the driver can, and is shown right away where it can't
+    std::uint32_t modeCount = 0;
+    vkGetPhysicalDeviceSurfacePresentModesKHR(physicalDevice, surface, &modeCount, nullptr);
+    std::vector<VkPresentModeKHR> modes(modeCount);
+    vkGetPhysicalDeviceSurfacePresentModesKHR(physicalDevice, surface, &modeCount, modes.data());
+    VkPresentModeKHR presentMode = VK_PRESENT_MODE_FIFO_KHR;
+    if (!settings.vsync) {
+        for (VkPresentModeKHR preferred : { VK_PRESENT_MODE_MAILBOX_KHR, VK_PRESENT_MODE_IMMEDIATE_KHR }) {
+            if (std::find(modes.begin(), modes.end(), preferred) != modes.end()) {
+                presentMode = preferred;
+                break;
+            }
+        }
+    }
+
+    // one image more than the minimum, the frames in flight don't wait for the display then
+    std::uint32_t imageCount = capabilities.minImageCount + 1;
+    if (capabilities.maxImageCount > 0) {
+        imageCount = std::min(imageCount, capabilities.maxImageCount);
+    }
+    if (capabilities.currentExtent.width != std::numeric_limits<std::uint32_t>::max()) {
+        extent = capabilities.currentExtent;
+    }
+
+    VkCompositeAlphaFlagBitsKHR compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
+    for (VkCompositeAlphaFlagBitsKHR candidate : { VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR, VK_COMPOSITE_ALPHA_INHERIT_BIT_KHR,
+                                                   VK_COMPOSITE_ALPHA_PRE_MULTIPLIED_BIT_KHR, VK_COMPOSITE_ALPHA_POST_MULTIPLIED_BIT_KHR }) {
+        if (capabilities.supportedCompositeAlpha & candidate) {
+            compositeAlpha = candidate;
+            break;
+        }
+    }
+
+    VkSwapchainCreateInfoKHR info{ VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR };
+    info.surface = surface;
+    info.minImageCount = imageCount;
+    info.imageFormat = surfaceFormat.format;
+    info.imageColorSpace = surfaceFormat.colorSpace;
+    info.imageExtent = extent;
+    info.imageArrayLayers = 1;
+    info.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+    info.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    info.preTransform = capabilities.currentTransform;
+    info.compositeAlpha = compositeAlpha;
+    info.presentMode = presentMode;
+    info.clipped = VK_TRUE;
+    if (vkCreateSwapchainKHR(device, &info, nullptr, &swapchain) != VK_SUCCESS) {
+        swapchain = VK_NULL_HANDLE;
+        std::cerr << "Failed to create the Vulkan swapchain" << std::endl;
+        return false;
+    }
+
+    // the render pass only depends on the format, which stays the same for the surface
+    if (!renderPass) {
+        format = surfaceFormat.format;
+        renderPass = createRenderPass(device, format, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
+        if (!renderPass) {
+            std::cerr << "Failed to create the Vulkan render pass" << std::endl;
+            return false;
+        }
+    }
+
+    vkGetSwapchainImagesKHR(device, swapchain, &imageCount, nullptr);
+    std::vector<VkImage> images(imageCount);
+    vkGetSwapchainImagesKHR(device, swapchain, &imageCount, images.data());
+    targets.resize(imageCount);
+    for (std::uint32_t i = 0; i < imageCount; i++) {
+        targets[i].image = images[i];
+        VkSemaphoreCreateInfo semaphoreInfo{ VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO };
+        if (!createFramebuffer(targets[i]) ||
+            vkCreateSemaphore(device, &semaphoreInfo, nullptr, &targets[i].rendered) != VK_SUCCESS) {
+            std::cerr << "Failed to set up the Vulkan swapchain images" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+void VulkanRenderer::destroySwapchain() {
+    for (Target& target : targets) {
+        vkDestroyFramebuffer(device, target.framebuffer, nullptr);
+        vkDestroyImageView(device, target.view, nullptr);
+        vkDestroySemaphore(device, target.rendered, nullptr);
+        // swapchain images belong to the swapchain
+        if (!swapchain) {
+            vkDestroyImage(device, target.image, nullptr);
+        }
+    }
+    targets.clear();
+    // not even a null swapchain offscreen, the device has no swapchain functions then
+    if (swapchain) {
+        vkDestroySwapchainKHR(device, swapchain, nullptr);
+        swapchain = VK_NULL_HANDLE;
+    }
+    vkFreeMemory(device, offscreenMemory, nullptr);
+    offscreenMemory = VK_NULL_HANDLE;
+}
+
+bool VulkanRenderer::createOffscreenTarget() {
+    format = VK_FORMAT_R8G8B8A8_UNORM;
+    renderPass = createRenderPass(device, format, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+    if (!renderPass) {
+        std::cerr << "Failed to create the Vulkan render pass" << std::endl;
+        return false;
+    }
+
+    targets.resize(1);
+    Target& target = targets[0];
+    VkImageCreateInfo imageInfo{ VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO };
+    imageInfo.imageType = VK_IMAGE_TYPE_2D;
+    imageInfo.format = format;
+    imageInfo.extent = { extent.width, extent.height, 1 };
+    imageInfo.mipLevels = 1;
+    imageInfo.arrayLayers = 1;
+    imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+    imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+    imageInfo.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+    imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    if (vkCreateImage(device, &imageInfo, nullptr, &target.image) != VK_SUCCESS) {
+        target.image = VK_NULL_HANDLE;
+        std::cerr << "Failed to create the Vulkan offscreen image" << std::endl;
+        return false;
+    }
+
+    VkMemoryRequirements requirements{};
+    vkGetImageMemoryRequirements(device, target.image, &requirements);
+    int memoryType = findMemoryType(requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+    if (memoryType < 0) {
+        memoryType = findMemoryType(requirements.memoryTypeBits, 0);
+    }
+    VkMemoryAllocateInfo allocation{ VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
+    allocation.allocationSize = requirements.size;
+    allocation.memoryTypeIndex = static_cast<std::uint32_t>(memoryType);
+    if (memoryType < 0 || vkAllocateMemory(device, &allocation, nullptr, &offscreenMemory) != VK_SUCCESS) {
+        offscreenMemory = VK_NULL_HANDLE;
+        std::cerr << "Failed to allocate the Vulkan offscreen image" << std::endl;
+        return false;
+    }
+    vkBindImageMemory(device, target.image, offscreenMemory, 0);
+
+    if (!createFramebuffer(target)) {
+        std::cerr << "Failed to set up the Vulkan offscreen image" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// ---------- pipelines ----------
+
+static VkShaderModule createShaderModule(VkDevice device, std::span<const std::uint32_t> code) {
+    VkShaderModuleCreateInfo info{ VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO };
+    info.codeSize = code.size_bytes();
+    info.pCode = code.data();
+    VkShaderModule module = VK_NULL_HANDLE;
+    if (vkCreateShaderModule(device, &info, nullptr, &module) != VK_SUCCESS) {
+        return VK_NULL_HANDLE;
+    }
+    return module;
+}
+
+bool VulkanRenderer::createPipelines() {
+    // the palette and the grid, from the slice of the frame in flight
+    VkDescriptorSetLayoutBinding bindings[2]{};
+    for (std::uint32_t i = 0; i < 2; i++) {
+        bindings[i].binding = i;
+        bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        bindings[i].descriptorCount = 1;
+        bindings[i].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+    }
+    VkDescriptorSetLayoutCreateInfo setInfo{ VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO };
+    setInfo.bindingCount = 2;
+    setInfo.pBindings = bindings;
+
+    // the Frame block, 64 bytes fit the 128 every device has
+    VkPushConstantRange pushConstants{ VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(FrameBlock) };
+    VkPipelineLayoutCreateInfo layoutInfo{ VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO };
+    layoutInfo.setLayoutCount = 1;
+    layoutInfo.pSetLayouts = &setLayout;
+    layoutInfo.pushConstantRangeCount = 1;
+    layoutInfo.pPushConstantRanges = &pushConstants;
+
+    if (vkCreateDescriptorSetLayout(device, &setInfo, nullptr, &setLayout) != VK_SUCCESS ||
+        vkCreatePipelineLayout(device, &layoutInfo, nullptr, &pipelineLayout) != VK_SUCCESS) {
+        std::cerr << "Failed to create the Vulkan pipeline layout" << std::endl;
+        return false;
+    }
+
+    // fills and outlines are computed per pixel, always smoothed analytically, like ProceduralScene
+    std::uint32_t features = shaderUtils::FeatureAnalyticAA;
+    if (settings.barrier.reverse) features |= shaderUtils::FeatureReverse;
+
+    std::span<const std::uint32_t> vertexCode = findSpirv("fullscreen_vertex.glsl", 0);
+    std::span<const std::uint32_t> stillCode = findSpirv("procedural_fragment.glsl", features);
+    std::span<const std::uint32_t> waveCode = findSpirv("procedural_fragment.glsl", features | shaderUtils::FeatureWave);
+    if (vertexCode.empty() || stillCode.empty() || waveCode.empty()) {
+        std::cerr << "Failed to find the Vulkan shaders, the build has no SPIR-V" << std::endl;
+        return false;
+    }
+
+    VkShaderModule vertexModule = createShaderModule(device, vertexCode);
+    VkShaderModule stillModule = createShaderModule(device, stillCode);
+    VkShaderModule waveModule = createShaderModule(device, waveCode);
+
+    VkPipelineShaderStageCreateInfo stages[2]{};
+    stages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    stages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+    stages[0].module = vertexModule;
+    stages[0].pName = "main";
+    stages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    stages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+    stages[1].pName = "main";
+
+    // one triangle from the vertex index, no attributes
+    VkPipelineVertexInputStateCreateInfo vertexInput{ VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO };
+    VkPipelineInputAssemblyStateCreateInfo inputAssembly{ VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO };
+    inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST;
+
+    VkPipelineViewportStateCreateInfo viewport{ VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO };
+    viewport.viewportCount = 1;
+    viewport.scissorCount = 1;
+    const VkDynamicState dynamicStates[] = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+    VkPipelineDynamicStateCreateInfo dynamic{ VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO };
+    dynamic.dynamicStateCount = 2;
+    dynamic.pDynamicStates = dynamicStates;
+
+    VkPipelineRasterizationStateCreateInfo rasterization{ VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO };
+    rasterization.polygonMode = VK_POLYGON_MODE_FILL;
+    rasterization.cullMode = VK_CULL_MODE_NONE;
+    rasterization.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+    rasterization.lineWidth = 1.0f;
+
+    // the edges are smoothed in the shader, multisampling would add nothing
+    VkPipelineMultisampleStateCreateInfo multisample{ VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO };
+    multisample.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+    // blended over the cleared background like glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA)
+    VkPipelineColorBlendAttachmentState blendAttachment{};
+    blendAttachment.blendEnable = VK_TRUE;
+    blendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+    blendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+    blendAttachment.colorBlendOp = VK_BLEND_OP_ADD;
+    blendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+    blendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+    blendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;
+    blendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+    VkPipelineColorBlendStateCreateInfo blend{ VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO };
+    blend.attachmentCount = 1;
+    blend.pAttachments = &blendAttachment;
+
+    VkGraphicsPipelineCreateInfo info{ VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO };
+    info.stageCount = 2;
+    info.pStages = stages;
+    info.pVertexInputState = &vertexInput;
+    info.pInputAssemblyState = &inputAssembly;
+    info.pViewportState = &viewport;
+    info.pRasterizationState = &rasterization;
+    info.pMultisampleState = &multisample;
+    info.pColorBlendState = &blend;
+    info.pDynamicState = &dynamic;
+    info.layout = pipelineLayout;
+    info.renderPass = renderPass;
+    info.basePipelineIndex = -1;
+
+    // both variants up front, a wave starting never waits for the driver's compiler
+    bool created = vertexModule && stillModule && waveModule;
+    if (created) {
+        stages[1].module = stillModule;
+        created = vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &info, nullptr, &still) == VK_SUCCESS;
+    }
+    if (created) {
+        stages[1].module = waveModule;
+        created = vkCreateGraphicsPipelines(device, VK_NULL_HANDLE, 1, &info, nullptr, &wave) == VK_SUCCESS;
+    }
+    vkDestroyShaderModule(device, vertexModule, nullptr);
+    vkDestroyShaderModule(device, stillModule, nullptr);
+    vkDestroyShaderModule(device, waveModule, nullptr);
+    if (!created) {
+        std::cerr << "Failed to create the Vulkan pipelines" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// ---------- frames in flight ----------
+
+bool VulkanRenderer::createFrames() {
+    VkBufferCreateInfo bufferInfo{ VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
+    bufferInfo.size = frameUniformsSize * framesInFlight;
+    bufferInfo.usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
+    bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    if (vkCreateBuffer(device, &bufferInfo, nullptr, &uniforms) != VK_SUCCESS) {
+        uniforms = VK_NULL_HANDLE;
+        std::cerr << "Failed to create the Vulkan uniform buffer" << std::endl;
+        return false;
+    }
+
+    // written by the CPU every frame and read once by the GPU, it stays mapped
+    VkMemoryRequirements requirements{};
+    vkGetBufferMemoryRequirements(device, uniforms, &requirements);
+    int memoryType = findMemoryType(requirements.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    VkMemoryAllocateInfo allocation{ VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
+    allocation.allocationSize = requirements.size;
+    allocation.memoryTypeIndex = static_cast<std::uint32_t>(memoryType);
+    void* mapped = nullptr;
+    if (memoryType < 0 || vkAllocateMemory(device, &allocation, nullptr, &uniformMemory) != VK_SUCCESS) {
+        uniformMemory = VK_NULL_HANDLE;
+        std::cerr << "Failed to allocate the Vulkan uniform buffer" << std::endl;
+        return false;
+    }
+    if (vkBindBufferMemory(device, uniforms, uniformMemory, 0) != VK_SUCCESS ||
+        vkMapMemory(device, uniformMemory, 0, VK_WHOLE_SIZE, 0, &mapped) != VK_SUCCESS) {
+        std::cerr << "Failed to map the Vulkan uniform buffer" << std::endl;
+        return false;
+    }
+    mappedUniforms = static_cast<std::uint8_t*>(mapped);
+
+    VkDescriptorPoolSize poolSize{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 2 * framesInFlight };
+    VkDescriptorPoolCreateInfo poolInfo{ VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO };
+    poolInfo.maxSets = framesInFlight;
+    poolInfo.poolSizeCount = 1;
+    poolInfo.pPoolSizes = &poolSize;
+
+    VkCommandPoolCreateInfo commandPoolInfo{ VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO };
+    commandPoolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT | VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+    commandPoolInfo.queueFamilyIndex = queueFamily;
+
+    if (vkCreateDescriptorPool(device, &poolInfo, nullptr, &descriptorPool) != VK_SUCCESS ||
+        vkCreateCommandPool(device, &commandPoolInfo, nullptr, &commandPool) != VK_SUCCESS) {
+        std::cerr << "Failed to create the Vulkan descriptor and command pools" << std::endl;
+        return false;
+    }
+
+    for (std::uint32_t i = 0; i < framesInFlight; i++) {
+        Frame& frame = frames[i];
+
+        VkDescriptorSetAllocateInfo setInfo{ VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO };
+        setInfo.descriptorPool = descriptorPool;
+        setInfo.descriptorSetCount = 1;
+        setInfo.pSetLayouts = &setLayout;
+
+        VkCommandBufferAllocateInfo commandInfo{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO };
+        commandInfo.commandPool = commandPool;
+        commandInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        commandInfo.commandBufferCount = 1;
+
+        // signaled, the first wait for a frame slot returns at once
+        VkFenceCreateInfo fenceInfo{ VK_STRUCTURE_TYPE_FENCE_CREATE_INFO };
+        fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+        VkSemaphoreCreateInfo semaphoreInfo{ VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO };
+
+        if (vkAllocateDescriptorSets(device, &setInfo, &frame.descriptors) != VK_SUCCESS ||
+            vkAllocateCommandBuffers(device, &commandInfo, &frame.commands) != VK_SUCCESS ||
+            vkCreateFence(device, &fenceInfo, nullptr, &frame.done) != VK_SUCCESS ||
+            vkCreateSemaphore(device, &semaphoreInfo, nullptr, &frame.acquired) != VK_SUCCESS) {
+            std::cerr << "Failed to set up the Vulkan frames in flight" << std::endl;
+            return false;
+        }
+
+        VkDescriptorBufferInfo blocks[2] = {
+            { uniforms, i * frameUniformsSize + paletteOffset, sizeof(PaletteBlock) },
+            { uniforms, i * frameUniformsSize + gridOffset, sizeof(GridBlock) },
+        };
+        VkWriteDescriptorSet writes[2]{};
+        for (std::uint32_t binding = 0; binding < 2; binding++) {
+            writes[binding].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            writes[binding].dstSet = frame.descriptors;
+            writes[binding].dstBinding = binding;
+            writes[binding].descriptorCount = 1;
+            writes[binding].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+            writes[binding].pBufferInfo = &blocks[binding];
+        }
+        vkUpdateDescriptorSets(device, 2, writes, 0, nullptr);
+    }
+    return true;
+}
+
+bool VulkanRenderer::drawFrame(const FrameState& state, const PaletteBlend& blend, const Color& background) {
+    Frame& frame = frames[frameIndex];
+
+    // the only wait of the frame: the slot's previous frame, framesInFlight frames ago
+    if (vkWaitForFences(device, 1, &frame.done, VK_TRUE, std::numeric_limits<std::uint64_t>::max()) != VK_SUCCESS) {
+        std::cerr << "Lost the Vulkan device" << std::endl;
+        return false;
+    }
+
+    std::uint32_t targetIndex = 0;
+    if (swapchain) {
+        VkResult acquired = vkAcquireNextImageKHR(device, swapchain, std::numeric_limits<std::uint64_t>::max(),
+                                                  frame.acquired, VK_NULL_HANDLE, &targetIndex);
+        if (acquired == VK_ERROR_OUT_OF_DATE_KHR) {
+            // the frame is dropped, the next one draws to the new swapchain
+            vkDeviceWaitIdle(device);
+            destroySwapchain();
+            return createSwapchain();
+        }
+        if (acquired != VK_SUCCESS && acquired != VK_SUBOPTIMAL_KHR) {
+            std::cerr << "Failed to acquire a Vulkan swapchain image" << std::endl;
+            return false;
+        }
+    }
+    vkResetFences(device, 1, &frame.done);
+
+    // the slot's blocks, the GPU is done reading them
+    std::uint8_t* slot = mappedUniforms + frameIndex * frameUniformsSize;
+    PaletteBlock palette = makePaletteBlock(settings.palettes, blend);
+    std::memcpy(slot + paletteOffset, &palette, sizeof(palette));
+    GridBlock grid{};
+    for (int i = 0; i < hexGrid::CornerCount; i++) {
+        grid.corners[i] = glm::vec4(layout.corners[i], 0.0f, 0.0f);
+    }
+    grid.hexagonWidth = layout.width;
+    grid.sliceWidth = layout.sliceWidth;
+    grid.yDistance = layout.yDistance;
+    grid.screenHeight = layout.screenHeight;
+    grid.seed = seed;
+    std::memcpy(slot + gridOffset, &grid, sizeof(grid));
+
+    // a handful of commands, recorded again every frame: push constants can't be left to
+    // pre-recorded secondary command buffers, which don't inherit them, and the pass has
+    // no geometry that a recording could keep
+    VkCommandBuffer commands = frame.commands;
+    vkResetCommandBuffer(commands, 0);
+    VkCommandBufferBeginInfo beginInfo{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    vkBeginCommandBuffer(commands, &beginInfo);
+
+    VkClearValue clear{};
+    std::memcpy(clear.color.float32, background.data(), sizeof(clear.color.float32));
+    VkRenderPassBeginInfo passInfo{ VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO };
+    passInfo.renderPass = renderPass;
+    passInfo.framebuffer = targets[targetIndex].framebuffer;
+    passInfo.renderArea = { { 0, 0 }, extent };
+    passInfo.clearValueCount = 1;
+    passInfo.pClearValues = &clear;
+    vkCmdBeginRenderPass(commands, &passInfo, VK_SUBPASS_CONTENTS_INLINE);
+
+    VkViewport viewport{ 0.0f, 0.0f, static_cast<float>(extent.width), static_cast<float>(extent.height), 0.0f, 1.0f };
+    VkRect2D scissor{ { 0, 0 }, extent };
+    vkCmdSetViewport(commands, 0, 1, &viewport);
+    vkCmdSetScissor(commands, 0, 1, &scissor);
+
+    FrameBlock block = makeFrameBlock(settings, state);
+    vkCmdBindPipeline(commands, VK_PIPELINE_BIND_POINT_GRAPHICS, state.waveProgress >= 0.0f ? wave : still);
+    vkCmdBindDescriptorSets(commands, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &frame.descriptors, 0, nullptr);
+    vkCmdPushConstants(commands, pipelineLayout, VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(block), &block);
+    vkCmdDraw(commands, 3, 1, 0, 0);
+
+    vkCmdEndRenderPass(commands);
+    vkEndCommandBuffer(commands);
+
+    const VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    VkSubmitInfo submit{ VK_STRUCTURE_TYPE_SUBMIT_INFO };
+    submit.commandBufferCount = 1;
+    submit.pCommandBuffers = &commands;
+    if (swapchain) {
+        submit.waitSemaphoreCount = 1;
+        submit.pWaitSemaphores = &frame.acquired;
+        submit.pWaitDstStageMask = &waitStage;
+        submit.signalSemaphoreCount = 1;
+        submit.pSignalSemaphores = &targets[targetIndex].rendered;
+    }
+    if (vkQueueSubmit(queue, 1, &submit, frame.done) != VK_SUCCESS) {
+        std::cerr << "Failed to submit a Vulkan frame" << std::endl;
+        return false;
+    }
+    frameIndex = (frameIndex + 1) % framesInFlight;
+
+    if (swapchain) {
+        VkPresentInfoKHR present{ VK_STRUCTURE_TYPE_PRESENT_INFO_KHR };
+        present.waitSemaphoreCount = 1;
+        present.pWaitSemaphores = &targets[targetIndex].rendered;
+        present.swapchainCount = 1;
+        present.pSwapchains = &swapchain;
+        present.pImageIndices = &targetIndex;
+        VkResult presented = vkQueuePresentKHR(queue, &present);
+        if (presented == VK_ERROR_OUT_OF_DATE_KHR || presented == VK_SUBOPTIMAL_KHR) {
+            vkDeviceWaitIdle(device);
+            destroySwapchain();
+            return createSwapchain();
+        }
+        if (presented != VK_SUCCESS) {
+            std::cerr << "Failed to present a Vulkan frame" << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+std::vector<std::uint8_t> VulkanRenderer::readback() {
+    if (swapchain || targets.empty()) {
+        return {};
+    }
+    const VkDeviceSize size = static_cast<VkDeviceSize>(extent.width) * extent.height * 4;
+
+    VkBufferCreateInfo bufferInfo{ VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO };
+    bufferInfo.size = size;
+    bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+    bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    VkBuffer buffer = VK_NULL_HANDLE;
+    if (vkCreateBuffer(device, &bufferInfo, nullptr, &buffer) != VK_SUCCESS) {
+        return {};
+    }
+    VkMemoryRequirements requirements{};
+    vkGetBufferMemoryRequirements(device, buffer, &requirements);
+    int memoryType = findMemoryType(requirements.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+    VkMemoryAllocateInfo allocation{ VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO };
+    allocation.allocationSize = requirements.size;
+    allocation.memoryTypeIndex = static_cast<std::uint32_t>(memoryType);
+    VkDeviceMemory memory = VK_NULL_HANDLE;
+    if (memoryType < 0 || vkAllocateMemory(device, &allocation, nullptr, &memory) != VK_SUCCESS) {
+        vkDestroyBuffer(device, buffer, nullptr);
+        return {};
+    }
+    vkBindBufferMemory(device, buffer, memory, 0);
+
+    // the render pass leaves the image ready for the copy, the barrier makes it visible to the host
+    VkCommandBuffer commands = VK_NULL_HANDLE;
+    VkCommandBufferAllocateInfo commandInfo{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO };
+    commandInfo.commandPool = commandPool;
+    commandInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    commandInfo.commandBufferCount = 1;
+    vkAllocateCommandBuffers(device, &commandInfo, &commands);
+    VkCommandBufferBeginInfo beginInfo{ VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO };
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    vkBeginCommandBuffer(commands, &beginInfo);
+
+    VkBufferImageCopy region{};
+    region.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+    region.imageExtent = { extent.width, extent.height, 1 };
+    vkCmdCopyImageToBuffer(commands, targets[0].image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, buffer, 1, &region);
+    VkMemoryBarrier toHost{ VK_STRUCTURE_TYPE_MEMORY_BARRIER };
+    toHost.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    toHost.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+    vkCmdPipelineBarrier(commands, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 1, &toHost, 0, nullptr, 0, nullptr);
+    vkEndCommandBuffer(commands);
+
+    VkSubmitInfo submit{ VK_STRUCTURE_TYPE_SUBMIT_INFO };
+    submit.commandBufferCount = 1;
+    submit.pCommandBuffers = &commands;
+    std::vector<std::uint8_t> pixels;
+    void* mapped = nullptr;
+    if (vkQueueSubmit(queue, 1, &submit, VK_NULL_HANDLE) == VK_SUCCESS && vkQueueWaitIdle(queue) == VK_SUCCESS &&
+        vkMapMemory(device, memory, 0, VK_WHOLE_SIZE, 0, &mapped) == VK_SUCCESS) {
+        // the image starts at the top row, glReadPixels at the bottom one
+        pixels.resize(static_cast<size_t>(size));
+        const size_t rowSize = static_cast<size_t>(extent.width) * 4;
+        for (std::uint32_t row = 0; row < extent.height; row++) {
+            std::memcpy(pixels.data() + row * rowSize, static_cast<const std::uint8_t*>(mapped) + (extent.height - 1 - row) * rowSize, rowSize);
+        }
+        vkUnmapMemory(device, memory);
+    }
+
+    vkFreeCommandBuffers(device, commandPool, 1, &commands);
+    vkDestroyBuffer(device, buffer, nullptr);
+    vkFreeMemory(device, memory, nullptr);
+    return pixels;
+}
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+#include "settings.h"
+#include "hexGrid.h"
+#include "hexScene.h"
+#include "palette.h"
+
+// The procedural scene drawn through Vulkan instead of OpenGL ("backend": "vulkan"). It is
+// the same full-screen pass as ProceduralScene, compiled to SPIR-V at build time: the
+// cursor and wave are push constants recorded with the draw instead of a streamed uniform
+// buffer, and the palette, grid and seed sit in a small host-visible uniform buffer with
+// one slice per frame in flight. Frames are paced explicitly: at most framesInFlight are
+// queued, a frame only waits for the fence of the one that used its slot before, and the
+// present mode follows vsync instead of a swap interval the driver may ignore.
+// Only the procedural mode is drawn, the other modes need the geometry of the GL scenes.
+class VulkanRenderer {
+public:
+    // what the renderer presents to: the instance extensions the surface needs, and how
+    // to create it once the instance exists. main.cpp gets both from GLFW
+    struct Surface {
+        std::vector<const char*> instanceExtensions;
+        std::function<VkResult(VkInstance instance, VkSurfaceKHR* surface)> create;
+    };
+
+    // presents to surface, which is width x height pixels. Returns nullptr when no device
+    // can draw to it or the build has no SPIR-V
+    static std::unique_ptr<VulkanRenderer> create(const Surface& surface, const Settings& settings,
+                                                  const hexGrid::Layout& layout, int width, int height, std::uint32_t seed);
+
+    // draws into a width x height image of its own instead, for tests and machines without
+    // a display. readback() copies it out
+    static std::unique_ptr<VulkanRenderer> createOffscreen(const Settings& settings, const hexGrid::Layout& layout,
+                                                           int width, int height, std::uint32_t seed);
+    ~VulkanRenderer();
+
+    VulkanRenderer(const VulkanRenderer&) = delete;
+    VulkanRenderer& operator=(const VulkanRenderer&) = delete;
+
+    // a new seed reshuffles the holes from the next frame on, nothing is rebuilt
+    void reseed(std::uint32_t seed) { this->seed = seed; }
+
+    // records, submits and presents one frame cleared to background. Returns false once
+    // the device or the surface is lost
+    bool drawFrame(const FrameState& frame, const PaletteBlend& blend, const Color& background);
+
+    // waits for the frames in flight and returns the last one as RGBA rows, bottom row
+    // first like glReadPixels. Offscreen only, empty on failure
+    std::vector<std::uint8_t> readback();
+
+private:
+    static constexpr std::uint32_t framesInFlight = 2;
+
+    VulkanRenderer(const Settings& settings, const hexGrid::Layout& layout) : settings(settings), layout(layout) {}
+
+    // everything but the surface and the render target
+    bool createInstance(const std::vector<const char*>& extensions);
+    bool createDevice();
+    bool createPipelines();
+    bool createFrames();
+
+    // the window target, again when the surface stops matching it
+    bool createSwapchain();
+    void destroySwapchain();
+
+    bool createOffscreenTarget();
+
+    // a memory type of typeBits with all of properties, -1 if there is none
+    int findMemoryType(std::uint32_t typeBits, VkMemoryPropertyFlags properties) const;
+
+    const Settings& settings;
+    const hexGrid::Layout layout;
+    std::uint32_t seed = 0;
+    VkExtent2D extent{};
+
+    VkInstance instance = VK_NULL_HANDLE;
+    VkSurfaceKHR surface = VK_NULL_HANDLE; // none when offscreen
+    VkPhysicalDevice physicalDevice = VK_NULL_HANDLE;
+    VkPhysicalDeviceMemoryProperties memoryProperties{};
+    std::uint32_t queueFamily = 0;
+    VkDevice device = VK_NULL_HANDLE;
+    VkQueue queue = VK_NULL_HANDLE;
+
+    VkFormat format = VK_FORMAT_R8G8B8A8_UNORM;
+    VkRenderPass renderPass = VK_NULL_HANDLE;
+    VkDescriptorSetLayout setLayout = VK_NULL_HANDLE;
+    VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+    VkPipeline still = VK_NULL_HANDLE; // EdgePrograms' variants, the wave one for frames it crosses
+    VkPipeline wave = VK_NULL_HANDLE;
+
+    // one target per swapchain image, or the offscreen image alone
+    VkSwapchainKHR swapchain = VK_NULL_HANDLE;
+    struct Target {
+        VkImage image = VK_NULL_HANDLE;
+        VkImageView view = VK_NULL_HANDLE;
+        VkFramebuffer framebuffer = VK_NULL_HANDLE;
+        VkSemaphore rendered = VK_NULL_HANDLE; // presentation waits for it
+    };
+    std::vector<Target> targets;
+    VkDeviceMemory offscreenMemory = VK_NULL_HANDLE;
+
+    // the view and the framebuffer of target.image
+    bool createFramebuffer(Target& target);
+
+    // what a frame in flight owns, reused once its fence is signaled
+    struct Frame {
+        VkCommandBuffer commands = VK_NULL_HANDLE;
+        VkFence done = VK_NULL_HANDLE;
+        VkSemaphore acquired = VK_NULL_HANDLE;
+        VkDescriptorSet descriptors = VK_NULL_HANDLE;
+    };
+    std::array<Frame, framesInFlight> frames{};
+    std::uint32_t frameIndex = 0;
+    VkCommandPool commandPool = VK_NULL_HANDLE;
+    VkDescriptorPool descriptorPool = VK_NULL_HANDLE;
+    VkBuffer uniforms = VK_NULL_HANDLE; // a palette and a grid block per frame in flight
+    VkDeviceMemory uniformMemory = VK_NULL_HANDLE;
+    std::uint8_t* mappedUniforms = nullptr;
+};
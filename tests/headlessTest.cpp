@@ -0,0 +1,157 @@
+// Draws every render mode through a headless OpenGL ES 3.0 context, without a surface and on
+// a pbuffer, the way a kiosk without a display server would. Fails when a shader doesn't
+// compile as GLSL ES, GL reports an error, a frame comes out blank, or a shuffled pattern
+// changed in place differs from one built from scratch. Runs from the source directory,
+// with Mesa on any Linux box: EGL_PLATFORM=surfaceless needs no GPU.
+
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "headlessContext.h"
+#include "gles.h"
+#include "settings.h"
+#include "hexGrid.h"
+#include "hexScene.h"
+#include "proceduralScene.h"
+#include "palette.h"
+#include "layerCache.h"
+#include "passList.h"
+#include "scenePasses.h"
+
+
+static constexpr int width = 640;
+static constexpr int height = 400;
+
+static int failures = 0;
+
+static void check(bool condition, const std::string& what) {
+    if (!condition) {
+        std::printf("FAILED: %s\n", what.c_str());
+        failures++;
+    }
+}
+
+// one frame with the cursor in the middle, read back from a resolved target
+static std::vector<std::uint8_t> drawFrame(const Settings& settings, const hexGrid::Layout& layout, HexScene& scene) {
+    std::unique_ptr<LayerCache> layerCache;
+    if (settings.layerCache && scene.cacheableFills()) {
+        layerCache = LayerCache::create(settings, layout, width, height);
+    }
+    PassList passes;
+    addScenePasses(passes, settings, layout, scene, layerCache.get(), width, height);
+
+    FrameState frame{};
+    frame.halfWidth = width * 0.5f;
+    frame.halfHeight = height * 0.5f;
+    frame.mousePos = glm::vec2(width * 0.5f, height * 0.5f);
+    frame.waveProgress = -1.0f;
+    frame.waveX = -999999.0f;
+    FrameUniformBuffer frameUniforms(settings);
+    frameUniforms.update(frame);
+
+    std::unique_ptr<RenderTarget> target = RenderTarget::create({ width, height, GL_RGBA8, settings.MSAA });
+    if (!target) {
+        return {};
+    }
+    target->bind();
+    glViewport(0, 0, width, height);
+    Color background = blendedBackground(settings.palettes, evaluatePalettes(settings.palettes, settings.paletteFade, 0.0f));
+    glClearColor(background[0], background[1], background[2], background[3]);
+    glClear(GL_COLOR_BUFFER_BIT);
+    passes.execute(frame);
+    target->resolve();
+
+    std::vector<std::uint8_t> pixels(static_cast<size_t>(width) * height * 4);
+    glBindFramebuffer(GL_FRAMEBUFFER, target->fbo);
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    return pixels;
+}
+
+static size_t colorCount(const std::vector<std::uint8_t>& pixels) {
+    std::set<std::uint32_t> colors;
+    for (size_t i = 0; i + 3 < pixels.size(); i += 4) {
+        colors.insert(pixels[i] | pixels[i + 1] << 8 | pixels[i + 2] << 16 | static_cast<std::uint32_t>(pixels[i + 3]) << 24);
+    }
+    return colors.size();
+}
+
+static void drawConfiguration(Settings settings) {
+    gles::adaptSettings(settings);
+    PaletteBuffer paletteBuffer(settings.palettes);
+    paletteBuffer.update(evaluatePalettes(settings.palettes, settings.paletteFade, 0.0f));
+
+    const hexGrid::Layout layout = hexGrid::makeLayout(settings.hexagonSize, width, height);
+    std::mt19937 rng(1);
+    const HexFills first = rollFills(settings, layout, rng);
+    const HexFills second = rollFills(settings, layout, rng);
+
+    char name[128];
+    std::snprintf(name, sizeof(name), "mode %d single-pass %d layer-cache %d MSAA %d",
+                  static_cast<int>(settings.renderMode), settings.singlePass, settings.layerCache, settings.MSAA);
+
+    std::unique_ptr<HexScene> scene = createHexScene(settings, layout, first);
+    check(scene != nullptr, std::string(name) + ": the scene builds");
+    if (!scene) {
+        return;
+    }
+    std::vector<std::uint8_t> pixels = drawFrame(settings, layout, *scene);
+    check(colorCount(pixels) > 3, std::string(name) + ": the frame shows the cubes");
+
+    // the shuffle of the main loop
+    bool inPlace = true;
+    if (auto* procedural = dynamic_cast<ProceduralScene*>(scene.get())) {
+        procedural->reseed(second.seed);
+    } else {
+        inPlace = scene->refill(second.hexagons, 0, second.hexagons.size());
+    }
+    if (inPlace) {
+        std::unique_ptr<HexScene> fresh = createHexScene(settings, layout, second);
+        check(fresh && drawFrame(settings, layout, *scene) == drawFrame(settings, layout, *fresh),
+              std::string(name) + ": a shuffle in place draws what a new scene does");
+    }
+
+    check(glGetError() == GL_NO_ERROR, std::string(name) + ": no GL errors");
+}
+
+int main() {
+    Settings settings = loadSettings("resource/settings.json");
+    settings.openGLES = true;
+
+    for (bool withPbuffer : { false, true }) {
+        std::unique_ptr<HeadlessContext> context = HeadlessContext::create(withPbuffer);
+        if (!context) {
+            std::printf("FAILED: no headless OpenGL ES 3.0 context\n");
+            return 1;
+        }
+        std::printf("%s: %s, %s\n", context->surfaceless() ? "surfaceless" : "pbuffer",
+                    reinterpret_cast<const char*>(glGetString(GL_RENDERER)), reinterpret_cast<const char*>(glGetString(GL_VERSION)));
+        check(gles::active(), "the context is OpenGL ES");
+
+        for (RenderMode mode : { RenderMode::Baked, RenderMode::Instanced, RenderMode::Procedural }) {
+            for (bool singlePass : { false, true }) {
+                for (bool layerCache : { false, true }) {
+                    for (int samples : { 0, 4 }) {
+                        settings.renderMode = mode;
+                        settings.singlePass = singlePass;
+                        settings.layerCache = layerCache;
+                        settings.MSAA = samples;
+                        drawConfiguration(settings);
+                    }
+                }
+            }
+        }
+    }
+
+    if (failures > 0) {
+        std::printf("%d checks failed\n", failures);
+        return 1;
+    }
+    std::printf("passed\n");
+    return 0;
+}
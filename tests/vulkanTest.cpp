@@ -0,0 +1,149 @@
+// Draws the procedural scene through the Vulkan backend into an offscreen image and compares
+// it with the same frame drawn through a headless OpenGL ES 3.0 context. Fails when the
+// backend can't be created, a frame comes out blank, or more than a handful of pixels differ
+// by more than rounding between the two drivers. Runs from the source directory, on Mesa's
+// lavapipe with EGL_PLATFORM=surfaceless, neither needs a GPU.
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "headlessContext.h"
+#include "gles.h"
+#include "glState.h"
+#include "settings.h"
+#include "hexGrid.h"
+#include "hexScene.h"
+#include "palette.h"
+#include "layerCache.h"
+#include "passList.h"
+#include "scenePasses.h"
+#include "vulkanRenderer.h"
+
+
+static constexpr int width = 640;
+static constexpr int height = 400;
+
+// the two drivers rasterize and round differently, edge pixels may be off by a few steps
+static constexpr int tolerance = 8;
+static constexpr double maxDifferentShare = 0.01;
+
+static int failures = 0;
+
+static void check(bool condition, const std::string& what) {
+    if (!condition) {
+        std::printf("FAILED: %s\n", what.c_str());
+        failures++;
+    }
+}
+
+// the frame through OpenGL ES, read back bottom row first
+static std::vector<std::uint8_t> drawGL(const Settings& settings, const hexGrid::Layout& layout, const HexFills& fills,
+                                        const FrameState& frame, const PaletteBlend& blend, const Color& background) {
+    std::unique_ptr<HexScene> scene = createHexScene(settings, layout, fills);
+    std::unique_ptr<RenderTarget> target = RenderTarget::create({ width, height, GL_RGBA8, 0 });
+    if (!scene || !target) {
+        return {};
+    }
+    PaletteBuffer paletteBuffer(settings.palettes);
+    paletteBuffer.update(blend);
+    PassList passes;
+    addScenePasses(passes, settings, layout, *scene, nullptr, width, height);
+    FrameUniformBuffer frameUniforms(settings);
+    frameUniforms.update(frame);
+
+    target->bind();
+    glViewport(0, 0, width, height);
+    glClearColor(background[0], background[1], background[2], background[3]);
+    glClear(GL_COLOR_BUFFER_BIT);
+    passes.execute(frame);
+
+    std::vector<std::uint8_t> pixels(static_cast<size_t>(width) * height * 4);
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    return pixels;
+}
+
+static void compare(const std::vector<std::uint8_t>& vulkan, const std::vector<std::uint8_t>& gl, const std::string& name) {
+    check(!vulkan.empty() && vulkan.size() == gl.size(), name + ": both backends draw the frame");
+    if (vulkan.empty() || vulkan.size() != gl.size()) {
+        return;
+    }
+    size_t different = 0;
+    bool blank = true;
+    for (size_t i = 0; i < vulkan.size(); i += 4) {
+        bool off = false;
+        for (size_t c = 0; c < 4; c++) {
+            off = off || std::abs(vulkan[i + c] - gl[i + c]) > tolerance;
+            blank = blank && vulkan[i + c] == vulkan[c];
+        }
+        different += off;
+    }
+    check(!blank, name + ": the frame shows the cubes");
+    const double share = static_cast<double>(different) / (vulkan.size() / 4);
+    check(share <= maxDifferentShare, name + ": " + std::to_string(different) + " pixels differ from OpenGL ES");
+}
+
+int main() {
+    Settings settings = loadSettings("resource/settings.json");
+    settings.openGLES = true;
+    settings.renderMode = RenderMode::Procedural;
+    settings.backend = Backend::Vulkan;
+    settings.MSAA = 0;
+
+    std::unique_ptr<HeadlessContext> context = HeadlessContext::create();
+    if (!context) {
+        std::printf("FAILED: no headless OpenGL ES 3.0 context\n");
+        return 1;
+    }
+    gles::adaptSettings(settings);
+    glEnable(GL_BLEND);
+    glState::blendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    const hexGrid::Layout layout = hexGrid::makeLayout(settings.hexagonSize, width, height);
+    std::mt19937 rng(1);
+    const HexFills first = rollFills(settings, layout, rng);
+    const HexFills second = rollFills(settings, layout, rng);
+
+    std::unique_ptr<VulkanRenderer> renderer = VulkanRenderer::createOffscreen(settings, layout, width, height, first.seed);
+    if (!renderer) {
+        std::printf("FAILED: no Vulkan renderer\n");
+        return 1;
+    }
+
+    const PaletteBlend blend = evaluatePalettes(settings.palettes, settings.paletteFade, 0.0f);
+    const Color background = blendedBackground(settings.palettes, blend);
+
+    FrameState frame{};
+    frame.halfWidth = width * 0.5f;
+    frame.halfHeight = height * 0.5f;
+    frame.mousePos = glm::vec2(width * 0.3f, height * 0.6f);
+    frame.waveProgress = -1.0f;
+    frame.waveX = -999999.0f;
+    check(renderer->drawFrame(frame, blend, background), "a still frame is drawn");
+    compare(renderer->readback(), drawGL(settings, layout, first, frame, blend, background), "still");
+
+    // the wave variant, halfway across
+    frame.waveProgress = 0.5f;
+    frame.waveX = width * 0.5f;
+    check(renderer->drawFrame(frame, blend, background), "a wave frame is drawn");
+    compare(renderer->readback(), drawGL(settings, layout, first, frame, blend, background), "wave");
+
+    // the shuffle of the main loop
+    renderer->reseed(second.seed);
+    check(renderer->drawFrame(frame, blend, background), "a reseeded frame is drawn");
+    compare(renderer->readback(), drawGL(settings, layout, second, frame, blend, background), "reseeded");
+
+    check(glGetError() == GL_NO_ERROR, "no GL errors");
+
+    if (failures > 0) {
+        std::printf("%d checks failed\n", failures);
+        return 1;
+    }
+    std::printf("passed\n");
+    return 0;
+}